@@ -42,6 +42,10 @@
 /* Calibration matrix: FLOAT, 9 values of a 3x3 matrix, in rows, read-only*/
 #define LIBINPUT_PROP_CALIBRATION_DEFAULT "libinput Calibration Matrix Default"
 
+/* Output area: CARD32, 4 values in order x, y, width, height in screen
+   coordinates. A width and height of 0 maps to the whole desktop */
+#define LIBINPUT_PROP_OUTPUT_AREA "libinput Output Area"
+
 /* Pointer accel speed: FLOAT, 1 value, 32 bit */
 #define LIBINPUT_PROP_ACCEL "libinput Accel Speed"
 
@@ -108,4 +112,92 @@
 /* Middle button emulation: BOOL, 1 value, read-only */
 #define LIBINPUT_PROP_MIDDLE_EMULATION_ENABLED_DEFAULT "libinput Middle Emulation Enabled Default"
 
+/* libinput log priority: 32-bit int, 1 value. 0 follows the server's
+   verbosity, otherwise one of libinput's log priorities (10 debug,
+   20 info, 30 error). Applies to all devices handled by this driver */
+#define LIBINPUT_PROP_LOG_PRIORITY "libinput Log Priority"
+
+/* Flight recorder: BOOL, 1 value. Setting it to 1 writes the flight
+   recorder to the FlightRecorderFile or the log */
+#define LIBINPUT_PROP_FLIGHT_RECORDER_DUMP "libinput Flight Recorder Dump"
+
+/* Statistics: 32-bit int, read-only, updated when read. Values in order
+   duplicate motion events suppressed on this device, log messages
+   suppressed by rate-limiting (all devices), motion events dropped
+   while the device was throttled, scroll events read, scroll events
+   posted after merging the ones read at once */
+#define LIBINPUT_PROP_STATISTICS "libinput Statistics"
+
+/* Flood control: 32-bit int, 3 values, read-only, updated when read.
+   Values in order FloodThreshold in events/s, events/s measured over the
+   last second, 1 if motion events are being throttled. Only present if
+   the FloodThreshold option is set */
+#define LIBINPUT_PROP_FLOOD "libinput Flood Control"
+
+/* Drain statistics: 32-bit int, 15 values, read-only, updated when read.
+   The same on all devices. Values in order: wakeups of the shared
+   libinput fd, wakeups with nothing to read, wakeups/s since the
+   previous read of this property, then a histogram of the events read
+   per wakeup in buckets of 0, 1, 2-3, 4-7, ... 512-1023, 1024+ events */
+#define LIBINPUT_PROP_DRAIN_STATISTICS "libinput Drain Statistics"
+
+/* Config batch: 32-bit int, write-only. A list of records, each the atom
+   of a libinput property, the number of values n, then n values. Values
+   are converted to the property's format, floats are given as their bit
+   pattern. All records are validated first, then all properties are
+   changed and the configuration is applied once. Reads give 0 values */
+#define LIBINPUT_PROP_CONFIG_BATCH "libinput Config Batch"
+
+/* Defaults: FLOAT, 22 values, read-only. Only present if the
+   CompactProperties option is set, replacing all *Default and *Available
+   properties. Values in order: tapping, tapping drag lock, natural
+   scrolling, left-handed, middle emulation, accel speed, send events
+   modes available, send events mode, scroll methods available, scroll
+   method, scroll button, click methods available, click method, then
+   the 9 values of the calibration matrix. Modes and methods are bitmasks
+   of libinput's enum values, e.g. 1 two-finger, 2 edge, 4 button
+   scrolling. Values for settings the device does not have are 0 */
+#define LIBINPUT_PROP_DEFAULTS "libinput Defaults"
+
+/* Device summary: 32-bit int, read-only, updated when read. The whole
+   device state in one request. Values in order:
+   0: version (2), 1: number of values, later versions only append
+   2: capabilities, bit 0 keyboard, 1 pointer, 2 touch
+   3, 4: vendor and product ID
+   5: settings available, bit 0 send events mode, 1 natural scrolling,
+      2 accel speed, 3 tapping, 4 tapping drag lock, 5 calibration
+      matrix and output area, 6 left-handed, 7 scroll method, 8 scroll
+      button, 9 click method, 10 middle emulation
+   6, 7: current and default boolean settings, bit 0 tapping, 1 tapping
+      drag lock, 2 natural scrolling, 3 left-handed, 4 middle emulation
+   8-10: send events mode, modes available, default mode
+   11-13: scroll method, methods available, default method
+   14-16: click method, methods available, default method
+   17, 18: scroll button, default scroll button
+   19, 20: accel speed, default accel speed, as float bit patterns
+   21-29, 30-38: calibration matrix, default matrix, as float bit patterns
+   39-42: output area x, y, width, height
+   43-50: logical button map of buttons 1-32, four 8-bit buttons per
+      value, lowest byte first
+   Version 2:
+   51-53: kinetic scrolling, time constant, interval, see
+      LIBINPUT_PROP_KINETIC_SCROLLING
+   54, 55: vertical and horizontal scroll distance, see
+      LIBINPUT_PROP_SCROLL_DISTANCE
+   Modes and methods are bitmasks of libinput's enum values, settings the
+   device does not have are 0 */
+#define LIBINPUT_PROP_SUMMARY "libinput Device Summary"
+
+/* Kinetic scrolling: 32-bit int, 3 values. Values in order 1 to keep
+   scrolling after the fingers are lifted, the time in ms for the
+   scrolling speed to drop to 1/e, the interval between scroll events in
+   ms (8 to 1000). Only present on devices with two-finger or edge
+   scrolling */
+#define LIBINPUT_PROP_KINETIC_SCROLLING "libinput Kinetic Scrolling"
+
+/* Scroll distance: 32-bit int, 2 values, vertical and horizontal. The
+   distance that makes up one legacy scroll button click, one wheel click
+   scrolls by this distance */
+#define LIBINPUT_PROP_SCROLL_DISTANCE "libinput Scroll Distance"
+
 #endif /* _LIBINPUT_PROPERTIES_H_ */
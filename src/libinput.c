@@ -26,22 +26,31 @@
 #endif
 
 #include <sys/epoll.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
 #include <errno.h>
 #include <fcntl.h>
+#include <limits.h>
+#include <math.h>
+#include <stddef.h>
 #include <time.h>
 #include <unistd.h>
 #include <xorg-server.h>
 #include <list.h>
 #include <exevents.h>
 #include <xkbsrv.h>
+#include <xf86.h>
 #include <xf86Xinput.h>
 #include <xserver-properties.h>
+#include <scrnintstr.h>
 #include <libinput.h>
 #include <linux/input.h>
 
 #include <X11/Xatom.h>
 
 #include "libinput-properties.h"
+#include "translate.h"
+#include "stats-export.h"
 
 #ifndef XI86_SERVER_FD
 #define XI86_SERVER_FD 0x20
@@ -53,9 +62,30 @@
 #undef HAVE_VMASK_UNACCEL
 #endif
 
-#define TOUCHPAD_NUM_AXES 4 /* x, y, hscroll, vscroll */
-#define TOUCH_MAX_SLOTS 15
-#define XORG_KEYCODE_OFFSET 8
+#if GET_ABI_MAJOR(ABI_XINPUT_VERSION) * 1000 + GET_ABI_MINOR(ABI_XINPUT_VERSION) >= 23000
+#define HAVE_THREADED_INPUT 1
+#endif
+
+#define TOUCHPAD_NUM_AXES TRANSLATE_NUM_VALUATORS
+#define TOUCH_MAX_SLOTS TRANSLATE_MAX_TOUCHES
+#define KEY_BURST_SIZE 128
+#define FLIGHT_RECORDER_SIZE 1024 /* must be a power of 2 */
+#define CACHELINE_SIZE 64
+#define FLOOD_WINDOW_US 1000000
+#define DRAIN_HISTOGRAM_SIZE 12 /* 0, 1, 2-3, 4-7, ..., 1024+ events */
+#define FLOOD_STRIKES 3 /* windows over/under the threshold to switch */
+/* motion streams decimated separately, see xf86libinput_flood_drop_motion() */
+#define FLOOD_STREAM_MOTION 0
+#define FLOOD_STREAM_ABSOLUTE 1
+#define FLOOD_STREAM_TOUCH 2 /* plus the slot */
+#define FLOOD_STREAMS (FLOOD_STREAM_TOUCH + TRANSLATE_MAX_TOUCHES)
+#define SCROLL_DISTANCE_DEFAULT 15
+#define SCROLL_DISTANCE_MAX 1000
+#define KINETIC_MIN_INTERVAL 8 /* ms between posts, at most 125/s */
+#define KINETIC_MAX_INTERVAL 1000
+#define KINETIC_MAX_TIME_CONSTANT 10000 /* ms */
+#define KINETIC_MAX_GAP 100 /* ms between finger events to track velocity */
+#define KINETIC_MIN_SPEED 0.05 /* scroll units/ms to start and keep coasting */
 
 /*
    libinput does not provide axis information for absolute devices, instead
@@ -65,36 +95,176 @@
  */
 #define TOUCH_AXIS_MAX 0xffff
 
+/* The parts of the libinput device config applied by
+   LibinputApplyConfigMask(), one per property that changes it. The
+   values are part of the libinput Device Summary property */
+enum config_bits {
+	CONFIG_SENDEVENTS = (1 << 0),
+	CONFIG_NATURAL_SCROLL = (1 << 1),
+	CONFIG_ACCEL = (1 << 2),
+	CONFIG_TAP = (1 << 3),
+	CONFIG_TAP_DRAG_LOCK = (1 << 4),
+	CONFIG_CALIBRATION = (1 << 5), /* and the output area */
+	CONFIG_LEFT_HANDED = (1 << 6),
+	CONFIG_SCROLL_METHOD = (1 << 7),
+	CONFIG_SCROLL_BUTTON = (1 << 8),
+	CONFIG_CLICK_METHOD = (1 << 9),
+	CONFIG_MIDDLE_EMULATION = (1 << 10),
+	CONFIG_ALL = (1 << 11) - 1,
+};
+
 struct xf86libinput_driver {
 	struct libinput *libinput;
 	int device_enabled_count;
 	struct xorg_list server_fds;
+	struct xorg_list devices;
+
+	OsTimerPtr led_timer;
+
+	/* set through the log priority property, 0 to follow the
+	   server's verbosity */
+	enum libinput_log_priority log_priority_override;
+	/* the priority currently set on the context */
+	enum libinput_log_priority log_priority;
+
+	char *flight_recorder_file;
+
+	uint64_t log_suppressed; /* by ratelimited logging */
+	struct ratelimit *ratelimit_pending; /* with suppressed messages */
+	OsTimerPtr ratelimit_timer;
+
+	int flood_devices; /* number of devices with a FloodThreshold */
+	int kinetic_devices; /* number of devices currently coasting */
+
+	/* all devices share one fd, these count the calls to read_input */
+	struct {
+		uint64_t wakeups;
+		uint64_t eagain; /* nothing to read */
+		uint64_t histogram[DRAIN_HISTOGRAM_SIZE]; /* events per drain */
+		/* wakeups/s between the last two reads of the property */
+		uint64_t last_wakeups;
+		uint64_t last_time;
+		unsigned int rate;
+	} drain;
+
+	/* mapped file in the StatisticsDirectory, NULL if not set */
+	struct stats_export_header *stats_export;
+	size_t stats_export_size;
+	char *stats_export_path;
+	uint32_t drain_time_ms; /* start of the current drain, for latency */
+
+	unsigned int watchdog_threshold; /* µs, 0 if disabled */
+
+	/* desktop bounding box last seen by the block handler */
+	struct {
+		int x, y, width, height;
+	} desktop;
 };
 
 static struct xf86libinput_driver driver_context;
 
 struct xf86libinput {
-	char *path;
+	/* Everything the event path touches comes first, the struct is
+	   allocated cache-line aligned. The first cache line has what is
+	   used for every event. The axis and translation state used for
+	   the respective event types follow, the per-touch state is at the
+	   end of the translation state. Then the state of the optional
+	   features, the event path only touches that while a feature is
+	   enabled. Configuration and everything else used rarely is kept
+	   after that. */
+	ValuatorMask *valuators;
 	struct libinput_device *device;
 
+	/* only allocated if KeyBurstMode is enabled */
 	struct {
-		int vdist;
-		int hdist;
-		int vdist_remainder;
-		int hdist_remainder;
-	} scroll;
+		struct {
+			uint16_t key;
+			uint16_t is_press;
+		} *keys;
+		int nkeys;
+	} burst;
+
+	BOOL has_abs;
 
+	/* consecutive axis events of one read are merged into one post,
+	   see xf86libinput_handle_axis() */
+	struct {
+		BOOL pending;
+		enum libinput_pointer_axis_source source;
+		uint64_t events; /* axis events read */
+		uint64_t posted; /* posts after merging */
+		double vert, vert_discrete;
+		double horiz, horiz_discrete;
+	} axis;
+
+	/* scroll distances still to be derived from the first wheel
+	   event, see xf86libinput_derive_scroll_distance() */
+	BOOL scroll_auto_vert;
+	BOOL scroll_auto_horiz;
+
+	/* absolute positions are in TOUCH_AXIS_MAX units */
+	struct translate_device core;
+
+	/* only used if FloodThreshold is set */
 	struct {
-		double x;
-		double y;
-		double x_remainder;
-		double y_remainder;
-	} scale;
+		unsigned int count; /* events in the current window */
+		unsigned int threshold; /* events/s, 0 if disabled */
+		unsigned int rate; /* events/s in the last window */
+		uint64_t window_start;
+		int over, under; /* consecutive windows over/under threshold */
+		BOOL throttled;
+		BOOL logged;
+		unsigned int decimation; /* post one in n motion events */
+		unsigned int seq[FLOOD_STREAMS];
+		/* relative motion of dropped events, added to the next
+		   event posted */
+		double dx, dy;
+		double dx_unaccel, dy_unaccel;
+		uint64_t dropped;
+	} flood;
+
+	/* only used if KineticScrolling is enabled */
+	struct {
+		BOOL enabled;
+		BOOL active;
+		unsigned int time_constant; /* ms for the velocity to drop to 1/e */
+		unsigned int interval; /* ms between posts */
+		OsTimerPtr timer;
+		/* finger velocity in scroll units/ms, tracked while scrolling */
+		double vx, vy;
+		uint32_t last_time;
+		/* velocity and server time when coasting started, ms of
+		   coasting posted so far */
+		double vx0, vy0;
+		CARD32 start;
+		double elapsed;
+	} kinetic;
+
+	/* only counted if the statistics file is enabled */
+	struct {
+		int slot; /* in the file, -1 if none */
+		uint64_t events[STATS_EXPORT_EVENT_TYPES];
+		uint64_t latency[STATS_EXPORT_LATENCY_BUCKETS];
+		uint64_t config_applied;
+	} export;
 
-	BOOL has_abs;
+	InputInfoPtr pInfo;
+	char *path;
+	struct xorg_list node; /* in driver_context.devices */
 
-	ValuatorMask *valuators;
-	ValuatorMask *valuators_unaccelerated;
+	BOOL has_output_area;
+	/* desktop bounding box the calibration matrix was last
+	   computed for, see xf86libinput_calc_matrix() */
+	struct {
+		int x, y;
+		int width, height;
+	} desktop;
+
+	struct {
+		int applied; /* -1 if unknown */
+		int pending;
+		BOOL needs_update;
+	} leds;
 
 	struct options {
 		BOOL tapping;
@@ -106,11 +276,24 @@ struct xf86libinput {
 		CARD32 scroll_button; /* xorg button number */
 		float speed;
 		float matrix[9];
+		/* in screen coordinates, width 0 for the whole desktop */
+		struct {
+			int x, y;
+			unsigned int width, height;
+		} output_area;
 		enum libinput_config_scroll_method scroll_method;
 		enum libinput_config_click_method click_method;
 
 		unsigned char btnmap[MAX_BUTTONS + 1];
+		/* libinput Defaults instead of the *Default and *Available
+		   properties */
+		BOOL compact_properties;
 	} options;
+
+	/* config_bits changed through properties but not applied yet */
+	uint32_t config_dirty;
+	/* bit n set if the property of prop_descriptions[n] exists */
+	uint64_t props;
 };
 
 /*
@@ -128,6 +311,22 @@ struct serverfd {
 	char *path;
 };
 
+#ifndef HAVE_THREADED_INPUT
+static int sigio_state;
+
+static inline void
+input_lock(void)
+{
+	sigio_state = xf86BlockSIGIO();
+}
+
+static inline void
+input_unlock(void)
+{
+	xf86UnblockSIGIO(sigio_state);
+}
+#endif
+
 static inline int
 use_server_fd(const InputInfoPtr pInfo) {
 	return pInfo->fd > -1 && (pInfo->flags & XI86_SERVER_FD);
@@ -140,156 +339,1354 @@ fd_push(struct xf86libinput_driver *context,
 {
 	struct serverfd *sfd = xnfcalloc(1, sizeof(*sfd));
 
-	sfd->fd = fd;
-	sfd->path = xnfstrdup(path);
-	xorg_list_add(&sfd->node, &context->server_fds);
+	sfd->fd = fd;
+	sfd->path = xnfstrdup(path);
+	xorg_list_add(&sfd->node, &context->server_fds);
+}
+
+static inline int
+fd_get(struct xf86libinput_driver *context,
+       const char *path)
+{
+	struct serverfd *sfd;
+
+	xorg_list_for_each_entry(sfd, &context->server_fds, node) {
+		if (strcmp(path, sfd->path) == 0)
+			return sfd->fd;
+	}
+
+	return -1;
+}
+
+static inline void
+fd_pop(struct xf86libinput_driver *context, int fd)
+{
+	struct serverfd *sfd;
+
+	xorg_list_for_each_entry(sfd, &context->server_fds, node) {
+		if (fd != sfd->fd)
+			continue;
+
+		xorg_list_del(&sfd->node);
+		free(sfd->path);
+		free(sfd);
+		break;
+	}
+}
+
+static inline int
+fd_find(struct xf86libinput_driver *context, int fd)
+{
+	struct serverfd *sfd;
+
+	xorg_list_for_each_entry(sfd, &context->server_fds, node) {
+		if (fd == sfd->fd)
+			return fd;
+	}
+	return -1;
+}
+
+/*
+   The flight recorder is an always-on ring buffer of the most recent log
+   messages, events and configuration changes. Records are fixed-size,
+   nothing is formatted until the buffer is dumped, so recording is a
+   clock read and a few stores. Log messages keep a copy of their format
+   and argument values, see flight_recorder_log(). Writers claim a slot
+   with an atomic increment and update it inside the same seqlock as the
+   statistics file (see stats-export.h), so the dump can skip records
+   that are being overwritten.
+ */
+enum flight_record_type {
+	FLIGHT_RECORD_LOG = 1,
+	FLIGHT_RECORD_EVENT,
+	FLIGHT_RECORD_CONFIG,
+};
+
+#define FLIGHT_RECORD_LOG_SIZE 102 /* records are 128 bytes */
+
+struct flight_record {
+	uint32_t lock; /* seqlock, odd while the record is written */
+	uint32_t seq; /* 0 if never written */
+	uint16_t type;
+	uint16_t detail; /* log priority or event type */
+	int32_t device; /* X device id, -1 for none */
+	uint64_t time; /* CLOCK_MONOTONIC, µs */
+	union {
+		struct {
+			uint8_t truncated; /* the rest didn't fit */
+			uint8_t nvalues; /* bytes of argument values */
+			/* the format, nul-terminated, then the argument values */
+			char data[FLIGHT_RECORD_LOG_SIZE];
+		} log;
+		struct {
+			uint32_t code;
+			uint32_t value;
+		} event;
+		struct {
+			uint32_t flags;
+			float speed;
+		} config;
+	} u;
+};
+
+static struct {
+	uint32_t next;
+	struct flight_record records[FLIGHT_RECORDER_SIZE];
+} flight_recorder;
+
+static inline uint64_t
+xf86libinput_now_us(void)
+{
+	struct timespec ts;
+
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return (uint64_t)ts.tv_sec * 1000000 + ts.tv_nsec / 1000;
+}
+
+static inline struct flight_record *
+flight_recorder_claim(enum flight_record_type type,
+		      uint16_t detail,
+		      int32_t device)
+{
+	struct flight_record *r;
+	uint32_t seq;
+
+	seq = __atomic_add_fetch(&flight_recorder.next, 1, __ATOMIC_RELAXED);
+	r = &flight_recorder.records[seq & (FLIGHT_RECORDER_SIZE - 1)];
+
+	stats_export_write_begin(&r->lock);
+	r->seq = seq;
+	r->type = type;
+	r->detail = detail;
+	r->time = xf86libinput_now_us();
+	r->device = device;
+
+	return r;
+}
+
+static inline void
+flight_recorder_commit(struct flight_record *r)
+{
+	stats_export_write_end(&r->lock);
+}
+
+/* The argument a printf conversion takes */
+enum log_arg {
+	LOG_ARG_NONE, /* %% */
+	LOG_ARG_INT,
+	LOG_ARG_UINT,
+	LOG_ARG_DOUBLE,
+	LOG_ARG_STRING,
+	LOG_ARG_POINTER,
+	LOG_ARG_UNSUPPORTED, /* %n, positional and wide arguments */
+};
+
+enum log_length {
+	LOG_LENGTH_NONE,
+	LOG_LENGTH_LONG,
+	LOG_LENGTH_LONG_LONG,
+	LOG_LENGTH_INTMAX,
+	LOG_LENGTH_SIZE,
+	LOG_LENGTH_PTRDIFF,
+	LOG_LENGTH_LONG_DOUBLE,
+};
+
+struct log_conversion {
+	const char *start; /* the % */
+	const char *length; /* the length modifier or conversion */
+	const char *end; /* after the conversion */
+	int nstars; /* int arguments for * width and precision */
+	enum log_length len;
+	enum log_arg arg;
+};
+
+/* Finds the next conversion in format. Returns FALSE if there is none */
+static BOOL
+log_format_next(const char *format, struct log_conversion *c)
+{
+	const char *p = strchr(format, '%');
+
+	if (!p)
+		return FALSE;
+
+	c->start = p++;
+	c->nstars = 0;
+	c->len = LOG_LENGTH_NONE;
+
+	p += strspn(p, "-+ #0'");
+	if (*p == '*') {
+		c->nstars++;
+		p++;
+	} else {
+		p += strspn(p, "0123456789");
+	}
+	if (*p == '.') {
+		p++;
+		if (*p == '*') {
+			c->nstars++;
+			p++;
+		} else {
+			p += strspn(p, "0123456789");
+		}
+	}
+
+	c->length = p;
+	switch (*p) {
+	case 'h': /* promoted to int */
+		p += (p[1] == 'h') ? 2 : 1;
+		break;
+	case 'l':
+		if (p[1] == 'l') {
+			c->len = LOG_LENGTH_LONG_LONG;
+			p++;
+		} else {
+			c->len = LOG_LENGTH_LONG;
+		}
+		p++;
+		break;
+	case 'q':
+		c->len = LOG_LENGTH_LONG_LONG;
+		p++;
+		break;
+	case 'j':
+		c->len = LOG_LENGTH_INTMAX;
+		p++;
+		break;
+	case 'z':
+		c->len = LOG_LENGTH_SIZE;
+		p++;
+		break;
+	case 't':
+		c->len = LOG_LENGTH_PTRDIFF;
+		p++;
+		break;
+	case 'L':
+		c->len = LOG_LENGTH_LONG_DOUBLE;
+		p++;
+		break;
+	}
+
+	switch (*p) {
+	case '%':
+		c->arg = LOG_ARG_NONE;
+		break;
+	case 'd':
+	case 'i':
+		c->arg = LOG_ARG_INT;
+		break;
+	case 'c':
+		c->arg = c->len == LOG_LENGTH_NONE ? LOG_ARG_INT : LOG_ARG_UNSUPPORTED;
+		break;
+	case 'u':
+	case 'o':
+	case 'x':
+	case 'X':
+		c->arg = LOG_ARG_UINT;
+		break;
+	case 'e':
+	case 'E':
+	case 'f':
+	case 'F':
+	case 'g':
+	case 'G':
+	case 'a':
+	case 'A':
+		c->arg = LOG_ARG_DOUBLE;
+		break;
+	case 's':
+		c->arg = c->len == LOG_LENGTH_NONE ? LOG_ARG_STRING : LOG_ARG_UNSUPPORTED;
+		break;
+	case 'p':
+		c->arg = LOG_ARG_POINTER;
+		break;
+	default:
+		c->arg = LOG_ARG_UNSUPPORTED;
+		break;
+	}
+
+	if (*p == '\0') {
+		c->arg = LOG_ARG_UNSUPPORTED;
+		c->end = p;
+	} else {
+		c->end = p + 1;
+	}
+
+	return TRUE;
+}
+
+/*
+   libinput's format may be built in a buffer on its stack, so the format
+   is copied into the record, followed by the raw values of the
+   arguments: ints are 4 bytes, other numbers and pointers 8 bytes and
+   strings are copied.
+   The first conversion that doesn't fit cuts off the rest of the
+   format.
+ */
+static inline void
+flight_recorder_log(enum libinput_log_priority priority,
+		    const char *format,
+		    va_list args)
+{
+	struct flight_record *r;
+	struct log_conversion c;
+	char values[FLIGHT_RECORD_LOG_SIZE];
+	const char *kept = format;
+	size_t nvalues = 0, len;
+	BOOL truncated = FALSE;
+	va_list copy;
+
+	va_copy(copy, args);
+	while (log_format_next(kept, &c)) {
+		char value[FLIGHT_RECORD_LOG_SIZE];
+		size_t size = 0;
+		int i;
+
+		if (c.arg == LOG_ARG_UNSUPPORTED) {
+			truncated = TRUE;
+			break;
+		}
+
+		for (i = 0; i < c.nstars; i++) {
+			int star = va_arg(copy, int);
+
+			memcpy(value + size, &star, sizeof(star));
+			size += sizeof(star);
+		}
+
+		switch (c.arg) {
+		case LOG_ARG_INT:
+		case LOG_ARG_UINT: {
+			/* unsigned values are stored with the same bits */
+			long long v;
+
+			/* most arguments are ints, keep them short */
+			if (c.len == LOG_LENGTH_NONE) {
+				int v32 = va_arg(copy, int);
+
+				memcpy(value + size, &v32, sizeof(v32));
+				size += sizeof(v32);
+				break;
+			}
+
+			switch (c.len) {
+			case LOG_LENGTH_LONG: v = va_arg(copy, long); break;
+			case LOG_LENGTH_LONG_LONG: v = va_arg(copy, long long); break;
+			case LOG_LENGTH_INTMAX: v = va_arg(copy, intmax_t); break;
+			case LOG_LENGTH_SIZE: v = va_arg(copy, ssize_t); break;
+			default: v = va_arg(copy, ptrdiff_t); break;
+			}
+			memcpy(value + size, &v, sizeof(v));
+			size += sizeof(v);
+			break;
+		}
+		case LOG_ARG_DOUBLE: {
+			double v;
+
+			if (c.len == LOG_LENGTH_LONG_DOUBLE)
+				v = va_arg(copy, long double);
+			else
+				v = va_arg(copy, double);
+			memcpy(value + size, &v, sizeof(v));
+			size += sizeof(v);
+			break;
+		}
+		case LOG_ARG_STRING: {
+			const char *str = va_arg(copy, const char *);
+
+			if (!str)
+				str = "(null)";
+			len = strnlen(str, sizeof(value) - size - 1);
+			memcpy(value + size, str, len);
+			value[size + len] = '\0';
+			size += len + 1;
+			break;
+		}
+		case LOG_ARG_POINTER: {
+			uint64_t v = (uintptr_t)va_arg(copy, void *);
+
+			memcpy(value + size, &v, sizeof(v));
+			size += sizeof(v);
+			break;
+		}
+		default:
+			break;
+		}
+
+		/* the format up to here, its nul and all values must fit */
+		if ((size_t)(c.end - format) + 1 + nvalues + size > sizeof(values)) {
+			truncated = TRUE;
+			break;
+		}
+
+		memcpy(values + nvalues, value, size);
+		nvalues += size;
+		kept = c.end;
+	}
+	va_end(copy);
+
+	/* the text after the last conversion kept */
+	len = kept - format;
+	if (!truncated)
+		len += strnlen(kept, sizeof(values) - 1 - nvalues - len);
+
+	r = flight_recorder_claim(FLIGHT_RECORD_LOG, priority, -1);
+	r->u.log.truncated = truncated;
+	r->u.log.nvalues = nvalues;
+	memcpy(r->u.log.data, format, len);
+	r->u.log.data[len] = '\0';
+	memcpy(r->u.log.data + len + 1, values, nvalues);
+	flight_recorder_commit(r);
+}
+
+static inline void
+flight_recorder_event(int32_t device,
+		      enum libinput_event_type type,
+		      uint32_t code,
+		      uint32_t value)
+{
+	struct flight_record *r;
+
+	r = flight_recorder_claim(FLIGHT_RECORD_EVENT, type, device);
+	r->u.event.code = code;
+	r->u.event.value = value;
+	flight_recorder_commit(r);
+}
+
+static inline void
+flight_recorder_config(int32_t device, uint32_t flags, float speed)
+{
+	struct flight_record *r;
+
+	r = flight_recorder_claim(FLIGHT_RECORD_CONFIG, 0, device);
+	r->u.config.flags = flags;
+	r->u.config.speed = speed;
+	flight_recorder_commit(r);
+}
+
+/* The directory for the files we write must belong to us or root and
+   must not be writable by anyone else, otherwise a file could be
+   replaced or read through a link planted in it. Returns an fd for the
+   directory or -1 */
+static int
+xf86libinput_open_private_dir(InputInfoPtr pInfo, const char *dir)
+{
+	struct stat st;
+	int dirfd;
+
+	dirfd = open(dir, O_RDONLY|O_DIRECTORY|O_NOFOLLOW|O_CLOEXEC);
+	if (dirfd < 0 || fstat(dirfd, &st) < 0) {
+		xf86IDrvMsg(pInfo, X_ERROR,
+			    "Failed to open directory %s: %s\n",
+			    dir, strerror(errno));
+		goto fail;
+	}
+
+	if ((st.st_uid != 0 && st.st_uid != geteuid()) ||
+	    (st.st_mode & (S_IWGRP|S_IWOTH))) {
+		xf86IDrvMsg(pInfo, X_ERROR,
+			    "Directory %s is writable by other users, not using it\n",
+			    dir);
+		goto fail;
+	}
+
+	return dirfd;
+
+fail:
+	if (dirfd >= 0)
+		close(dirfd);
+	return -1;
+}
+
+/* Writes the conversion c into spec with the values of its * width
+   and precision filled in, so it takes a single argument */
+static BOOL
+log_conversion_spec(const struct log_conversion *c,
+		    const int *stars,
+		    char *spec,
+		    size_t size)
+{
+	const char *p;
+	size_t len = 0;
+	int n = 0;
+
+	for (p = c->start; p < c->end; p++) {
+		if (len + 1 >= size)
+			return FALSE;
+
+		if (*p != '*') {
+			spec[len++] = *p;
+			continue;
+		}
+
+		/* a negative precision is taken as if it was omitted */
+		if (stars[n] < 0 && spec[len - 1] == '.') {
+			len--;
+			n++;
+			continue;
+		}
+
+		len += snprintf(spec + len, size - len, "%d", stars[n++]);
+		if (len >= size)
+			return FALSE;
+	}
+	spec[len] = '\0';
+
+	return TRUE;
+}
+
+/* spec is a conversion read back from a log record, so it can't be
+   checked against the arguments at compile time. The caller passes the
+   argument type the conversion takes, see log_format_next() */
+#pragma GCC diagnostic push
+#pragma GCC diagnostic ignored "-Wsuggest-attribute=format"
+static int
+flight_recorder_format_value(char *buf, size_t size, const char *spec, ...)
+{
+	va_list args;
+	int len;
+
+	va_start(args, spec);
+	len = vsnprintf(buf, size, spec, args);
+	va_end(args);
+
+	return len;
+}
+#pragma GCC diagnostic pop
+
+/* Formats a log record, see flight_recorder_log() */
+static int
+flight_recorder_format_log(char *buf, size_t size,
+			   const struct flight_record *r)
+{
+	const char *format = r->u.log.data;
+	const char *values = format + strlen(format) + 1;
+	const char *end = values + r->u.log.nvalues;
+	struct log_conversion c;
+	char spec[32];
+	int len = 0;
+
+	while (len < size && log_format_next(format, &c)) {
+		int stars[2];
+		long long v = 0;
+		double d = 0;
+		const char *str = NULL;
+		int i, n;
+
+		len += snprintf(buf + len, size - len, "%.*s",
+				(int)(c.start - format), format);
+		format = c.end;
+
+		for (i = 0; i < c.nstars; i++) {
+			if ((size_t)(end - values) < sizeof(stars[i]))
+				goto out;
+			memcpy(&stars[i], values, sizeof(stars[i]));
+			values += sizeof(stars[i]);
+		}
+
+		if (len >= size || !log_conversion_spec(&c, stars, spec, sizeof(spec)))
+			goto out;
+
+		switch (c.arg) {
+		case LOG_ARG_INT:
+		case LOG_ARG_UINT:
+			if (c.len == LOG_LENGTH_NONE) {
+				int v32;
+
+				if ((size_t)(end - values) < sizeof(v32))
+					goto out;
+				memcpy(&v32, values, sizeof(v32));
+				values += sizeof(v32);
+				v = v32;
+				break;
+			}
+			/* fallthrough */
+		case LOG_ARG_POINTER:
+			if ((size_t)(end - values) < sizeof(v))
+				goto out;
+			memcpy(&v, values, sizeof(v));
+			values += sizeof(v);
+			break;
+		case LOG_ARG_DOUBLE:
+			if ((size_t)(end - values) < sizeof(d))
+				goto out;
+			memcpy(&d, values, sizeof(d));
+			values += sizeof(d);
+			break;
+		case LOG_ARG_STRING:
+			str = values;
+			values = memchr(values, '\0', end - values);
+			if (!values)
+				goto out;
+			values++;
+			break;
+		default:
+			break;
+		}
+
+		switch (c.arg) {
+		case LOG_ARG_NONE:
+			n = snprintf(buf + len, size - len, "%%");
+			break;
+		case LOG_ARG_INT:
+			switch (c.len) {
+			case LOG_LENGTH_LONG: n = flight_recorder_format_value(buf + len, size - len, spec, (long)v); break;
+			case LOG_LENGTH_LONG_LONG: n = flight_recorder_format_value(buf + len, size - len, spec, v); break;
+			case LOG_LENGTH_INTMAX: n = flight_recorder_format_value(buf + len, size - len, spec, (intmax_t)v); break;
+			case LOG_LENGTH_SIZE: n = flight_recorder_format_value(buf + len, size - len, spec, (ssize_t)v); break;
+			case LOG_LENGTH_PTRDIFF: n = flight_recorder_format_value(buf + len, size - len, spec, (ptrdiff_t)v); break;
+			default: n = flight_recorder_format_value(buf + len, size - len, spec, (int)v); break;
+			}
+			break;
+		case LOG_ARG_UINT:
+			switch (c.len) {
+			case LOG_LENGTH_LONG: n = flight_recorder_format_value(buf + len, size - len, spec, (unsigned long)v); break;
+			case LOG_LENGTH_LONG_LONG: n = flight_recorder_format_value(buf + len, size - len, spec, (unsigned long long)v); break;
+			case LOG_LENGTH_INTMAX: n = flight_recorder_format_value(buf + len, size - len, spec, (uintmax_t)v); break;
+			case LOG_LENGTH_SIZE: n = flight_recorder_format_value(buf + len, size - len, spec, (size_t)v); break;
+			case LOG_LENGTH_PTRDIFF: n = flight_recorder_format_value(buf + len, size - len, spec, (ptrdiff_t)v); break;
+			default: n = flight_recorder_format_value(buf + len, size - len, spec, (unsigned int)v); break;
+			}
+			break;
+		case LOG_ARG_DOUBLE:
+			if (c.len == LOG_LENGTH_LONG_DOUBLE)
+				n = flight_recorder_format_value(buf + len, size - len, spec, (long double)d);
+			else
+				n = flight_recorder_format_value(buf + len, size - len, spec, d);
+			break;
+		case LOG_ARG_STRING:
+			n = flight_recorder_format_value(buf + len, size - len, spec, str);
+			break;
+		case LOG_ARG_POINTER:
+			n = flight_recorder_format_value(buf + len, size - len, spec, (void*)(uintptr_t)v);
+			break;
+		default:
+			n = 0;
+			break;
+		}
+
+		if (n < 0)
+			goto out;
+		len += n;
+	}
+
+	if (len < size)
+		len += snprintf(buf + len, size - len, "%s%s", format,
+				r->u.log.truncated ? "..." : "");
+
+out:
+	return min(len, (int)size - 1);
+}
+
+/*
+   The dump is written to a new file under a temporary name in the same
+   directory and renamed into place, as the statistics file, so an
+   existing file or link of that name is replaced, never written to.
+   Returns the fd and the directory's fd in dirfd, or -1
+ */
+static int
+flight_recorder_open(InputInfoPtr pInfo, const char *path,
+		     int *dirfd, char *tmpname, size_t size)
+{
+	const char *name = strrchr(path, '/');
+	char *dir;
+	struct stat st;
+	int fd;
+
+	if (name) {
+		dir = strndup(path, max(name - path, 1));
+		name++;
+	} else {
+		dir = strdup(".");
+		name = path;
+	}
+
+	if (!dir)
+		return -1;
+
+	*dirfd = xf86libinput_open_private_dir(pInfo, dir);
+	free(dir);
+	if (*dirfd < 0)
+		return -1;
+
+	if (snprintf(tmpname, size, ".%s.tmp", name) >= size) {
+		xf86IDrvMsg(pInfo, X_ERROR,
+			    "Flight recorder file name %s is too long\n", path);
+		goto fail;
+	}
+
+	/* a leftover temporary file is from an earlier dump */
+	unlinkat(*dirfd, tmpname, 0);
+	fd = openat(*dirfd, tmpname,
+		    O_WRONLY|O_CREAT|O_EXCL|O_NOFOLLOW|O_CLOEXEC, 0600);
+	if (fd < 0) {
+		xf86IDrvMsg(pInfo, X_ERROR,
+			    "Failed to open %s for the flight recorder: %s\n",
+			    path, strerror(errno));
+		goto fail;
+	}
+
+	/* O_EXCL guarantees we created it, check it's the file we asked for */
+	if (fstat(fd, &st) < 0 || !S_ISREG(st.st_mode) ||
+	    st.st_uid != geteuid() || st.st_nlink != 1) {
+		xf86IDrvMsg(pInfo, X_ERROR,
+			    "Failed to create %s for the flight recorder\n",
+			    path);
+		close(fd);
+		unlinkat(*dirfd, tmpname, 0);
+		goto fail;
+	}
+
+	return fd;
+
+fail:
+	close(*dirfd);
+	*dirfd = -1;
+	return -1;
+}
+
+static inline unsigned int
+drain_bucket(unsigned int nevents)
+{
+	unsigned int bucket = nevents ? 32 - __builtin_clz(nevents) : 0;
+
+	return min(bucket, DRAIN_HISTOGRAM_SIZE - 1);
+}
+
+static void
+xf86libinput_format_drain_stats(char *buf, size_t size)
+{
+	int len;
+	size_t i;
+
+	len = snprintf(buf, size, "drain wakeups %llu eagain %llu histogram",
+		       (unsigned long long)driver_context.drain.wakeups,
+		       (unsigned long long)driver_context.drain.eagain);
+
+	for (i = 0; i < DRAIN_HISTOGRAM_SIZE && len > 0 && len < size; i++)
+		len += snprintf(buf + len, size - len, " %llu",
+				(unsigned long long)driver_context.drain.histogram[i]);
+}
+
+static void
+flight_recorder_dump(InputInfoPtr pInfo)
+{
+	const char *path = driver_context.flight_recorder_file;
+	uint32_t last;
+	int fd = -1, dirfd = -1;
+	char line[512];
+	char tmpname[NAME_MAX + 1];
+	size_t i;
+
+	if (path) {
+		fd = flight_recorder_open(pInfo, path, &dirfd,
+					  tmpname, sizeof(tmpname));
+		if (fd < 0)
+			return;
+	}
+
+	last = __atomic_load_n(&flight_recorder.next, __ATOMIC_ACQUIRE);
+
+	xf86libinput_format_drain_stats(line, sizeof(line));
+	if (fd >= 0)
+		dprintf(fd, "%s\n", line);
+	else
+		LogMessageVerb(X_INFO, -1, "libinput: %s\n", line);
+
+	for (i = 0; i < FLIGHT_RECORDER_SIZE; i++) {
+		struct flight_record r, *rp;
+		uint32_t lock;
+		int len = 0;
+
+		rp = &flight_recorder.records[(last + 1 + i) & (FLIGHT_RECORDER_SIZE - 1)];
+		if (!stats_export_read_begin(&rp->lock, &lock))
+			continue;
+
+		r = *rp;
+		/* overwritten while we copied it */
+		if (!stats_export_read_end(&rp->lock, lock) || r.seq == 0)
+			continue;
+
+		switch (r.type) {
+		case FLIGHT_RECORD_LOG:
+			len = snprintf(line, sizeof(line),
+				       "%llu.%06llu log %u: ",
+				       (unsigned long long)r.time/1000000,
+				       (unsigned long long)r.time % 1000000,
+				       r.detail);
+			if (len > 0 && len < sizeof(line))
+				len += flight_recorder_format_log(line + len,
+								  sizeof(line) - len,
+								  &r);
+			/* libinput's messages end in a newline */
+			if (len > 0 && len < sizeof(line) && line[len - 1] == '\n')
+				line[--len] = '\0';
+			break;
+		case FLIGHT_RECORD_EVENT:
+			len = snprintf(line, sizeof(line),
+				       "%llu.%06llu event device %d type %u code %u value %u",
+				       (unsigned long long)r.time/1000000,
+				       (unsigned long long)r.time % 1000000,
+				       r.device, r.detail,
+				       r.u.event.code, r.u.event.value);
+			break;
+		case FLIGHT_RECORD_CONFIG:
+			len = snprintf(line, sizeof(line),
+				       "%llu.%06llu config device %d flags %#x speed %.2f",
+				       (unsigned long long)r.time/1000000,
+				       (unsigned long long)r.time % 1000000,
+				       r.device, r.u.config.flags,
+				       r.u.config.speed);
+			break;
+		}
+
+		if (len <= 0)
+			continue;
+
+		if (fd >= 0)
+			dprintf(fd, "%s\n", line);
+		else
+			LogMessageVerb(X_INFO, -1, "libinput: %s\n", line);
+	}
+
+	if (fd >= 0) {
+		const char *name = strrchr(path, '/');
+
+		name = name ? name + 1 : path;
+		if (close(fd) < 0 || renameat(dirfd, tmpname, dirfd, name) < 0) {
+			xf86IDrvMsg(pInfo, X_ERROR,
+				    "Failed to write the flight recorder to %s: %s\n",
+				    path, strerror(errno));
+			unlinkat(dirfd, tmpname, 0);
+		} else {
+			xf86IDrvMsg(pInfo, X_INFO, "Flight recorder written to %s\n", path);
+		}
+		close(dirfd);
+	}
+}
+
+/*
+   Rate-limiting for messages on the event path, a misbehaving device must
+   not be able to flood the log. Each call site has its own ratelimit,
+   up to burst messages are logged per interval, the rest is counted and
+   summarized once the interval expires. Ratelimits with suppressed
+   messages are kept in a list, a timer writes their summary when the
+   interval expires, disabling a device writes it right away.
+ */
+struct ratelimit {
+	uint64_t interval; /* ms */
+	unsigned int burst;
+	uint64_t begin;
+	unsigned int num;
+	/* set while messages are suppressed */
+	InputInfoPtr pInfo;
+	MessageType type;
+	struct ratelimit *next; /* in driver_context.ratelimit_pending */
+};
+
+#define RATELIMIT_INIT(interval_ms, burst_) { .interval = interval_ms, .burst = burst_ }
+
+/* Log the summary of the messages suppressed in the current interval
+   and start a new one with the next message */
+static void
+xf86libinput_ratelimit_flush(struct ratelimit *rl)
+{
+	struct ratelimit **p;
+
+	if (rl->pInfo) {
+		xf86IDrvMsg(rl->pInfo, rl->type,
+			    "%u similar messages suppressed\n",
+			    rl->num - rl->burst);
+
+		for (p = &driver_context.ratelimit_pending; *p; p = &(*p)->next) {
+			if (*p == rl) {
+				*p = rl->next;
+				break;
+			}
+		}
+		rl->next = NULL;
+		rl->pInfo = NULL;
+	}
+
+	rl->begin = 0;
+	rl->num = 0;
+}
+
+static CARD32
+xf86libinput_ratelimit_timer(OsTimerPtr timer, CARD32 time, pointer data)
+{
+	uint64_t now = xf86libinput_now_us() / 1000;
+	struct ratelimit *rl, *next;
+	CARD32 timeout = 0;
+
+	input_lock();
+	for (rl = driver_context.ratelimit_pending; rl; rl = next) {
+		next = rl->next;
+
+		if (now - rl->begin >= rl->interval)
+			xf86libinput_ratelimit_flush(rl);
+		else if (timeout == 0 || rl->begin + rl->interval - now < timeout)
+			timeout = rl->begin + rl->interval - now;
+	}
+	input_unlock();
+
+	return timeout;
+}
+
+/* Write the pending summaries for this device, called before the
+   device goes away */
+static void
+xf86libinput_ratelimit_flush_device(InputInfoPtr pInfo)
+{
+	struct ratelimit *rl, *next;
+
+	input_lock();
+	for (rl = driver_context.ratelimit_pending; rl; rl = next) {
+		next = rl->next;
+		if (rl->pInfo == pInfo)
+			xf86libinput_ratelimit_flush(rl);
+	}
+	input_unlock();
+}
+
+static void
+xf86libinput_log_ratelimit(InputInfoPtr pInfo,
+			   struct ratelimit *rl,
+			   MessageType type,
+			   const char *format,
+			   ...)
+	_X_ATTRIBUTE_PRINTF(4, 5);
+
+static void
+xf86libinput_log_ratelimit(InputInfoPtr pInfo,
+			   struct ratelimit *rl,
+			   MessageType type,
+			   const char *format,
+			   ...)
+{
+	uint64_t now = xf86libinput_now_us() / 1000;
+	va_list args;
+
+	if (rl->begin == 0 || now - rl->begin >= rl->interval) {
+		xf86libinput_ratelimit_flush(rl);
+		rl->begin = now;
+	}
+
+	if (++rl->num > rl->burst) {
+		driver_context.log_suppressed++;
+
+		if (!rl->pInfo) {
+			rl->pInfo = pInfo;
+			rl->type = type;
+			/* the timer is running while the list isn't empty */
+			if (!driver_context.ratelimit_pending)
+				driver_context.ratelimit_timer =
+					TimerSet(driver_context.ratelimit_timer, 0,
+						 rl->begin + rl->interval - now,
+						 xf86libinput_ratelimit_timer, NULL);
+			rl->next = driver_context.ratelimit_pending;
+			driver_context.ratelimit_pending = rl;
+		}
+		return;
+	}
+
+	va_start(args, format);
+	xf86VIDrvMsgVerb(pInfo, type, 0, format, args);
+	va_end(args);
+
+	if (rl->num == rl->burst)
+		xf86IDrvMsg(pInfo, type,
+			    "suppressing similar messages for %us\n",
+			    (unsigned int)(rl->interval / 1000));
+}
+
+static inline struct stats_export_device *
+stats_export_slot(int slot)
+{
+	return (struct stats_export_device*)((char*)driver_context.stats_export +
+					     sizeof(struct stats_export_header) +
+					     slot * sizeof(struct stats_export_device));
+}
+
+static void
+xf86libinput_stats_export_open(InputInfoPtr pInfo, const char *dir)
+{
+	struct stats_export_header *header = MAP_FAILED;
+	size_t size, len;
+	char *path;
+	char name[64], tmpname[80];
+	int dirfd, fd = -1;
+	int i;
+
+	dirfd = xf86libinput_open_private_dir(pInfo, dir);
+	if (dirfd < 0)
+		return;
+
+	snprintf(name, sizeof(name), "xf86-input-libinput-%d.stats", (int)getpid());
+	snprintf(tmpname, sizeof(tmpname), ".%s.tmp", name);
+
+	len = strlen(dir) + sizeof(name) + 1;
+	path = malloc(len);
+	if (!path) {
+		close(dirfd);
+		return;
+	}
+	snprintf(path, len, "%s/%s", dir, name);
+
+	size = sizeof(struct stats_export_header) +
+	       STATS_EXPORT_MAX_DEVICES * sizeof(struct stats_export_device);
+
+	/* The file is set up under a temporary name and renamed into
+	   place, so readers never see a partial file and an existing
+	   file or link of the same name is replaced, not written to. A
+	   leftover temporary file can only be ours from an earlier
+	   server with the same pid */
+	unlinkat(dirfd, tmpname, 0);
+	fd = openat(dirfd, tmpname,
+		    O_RDWR|O_CREAT|O_EXCL|O_NOFOLLOW|O_CLOEXEC, 0600);
+	if (fd < 0 || ftruncate(fd, size) < 0) {
+		xf86IDrvMsg(pInfo, X_ERROR,
+			    "Failed to create statistics file %s: %s\n",
+			    path, strerror(errno));
+		goto fail;
+	}
+
+	header = mmap(NULL, size, PROT_READ|PROT_WRITE, MAP_SHARED, fd, 0);
+	if (header == MAP_FAILED) {
+		xf86IDrvMsg(pInfo, X_ERROR,
+			    "Failed to map statistics file %s: %s\n",
+			    path, strerror(errno));
+		goto fail;
+	}
+
+	driver_context.stats_export = header;
+
+	for (i = 0; i < STATS_EXPORT_MAX_DEVICES; i++)
+		stats_export_slot(i)->id = -1;
+
+	header->header_size = sizeof(struct stats_export_header);
+	header->device_size = sizeof(struct stats_export_device);
+	header->max_devices = STATS_EXPORT_MAX_DEVICES;
+	header->version = STATS_EXPORT_VERSION;
+	/* readers check this first, so write it last */
+	__atomic_store_n(&header->magic, STATS_EXPORT_MAGIC, __ATOMIC_RELEASE);
+
+	if (renameat(dirfd, tmpname, dirfd, name) < 0) {
+		xf86IDrvMsg(pInfo, X_ERROR,
+			    "Failed to create statistics file %s: %s\n",
+			    path, strerror(errno));
+		driver_context.stats_export = NULL;
+		goto fail;
+	}
+	close(fd);
+	close(dirfd);
+
+	driver_context.stats_export_size = size;
+	driver_context.stats_export_path = path;
+
+	xf86IDrvMsg(pInfo, X_INFO, "Writing statistics to %s\n", path);
+	return;
+
+fail:
+	if (header != MAP_FAILED)
+		munmap(header, size);
+	if (fd >= 0) {
+		close(fd);
+		unlinkat(dirfd, tmpname, 0);
+	}
+	close(dirfd);
+	free(path);
+}
+
+static void
+xf86libinput_stats_export_close(void)
+{
+	if (!driver_context.stats_export)
+		return;
+
+	munmap(driver_context.stats_export, driver_context.stats_export_size);
+	unlink(driver_context.stats_export_path);
+	free(driver_context.stats_export_path);
+	driver_context.stats_export = NULL;
+	driver_context.stats_export_path = NULL;
+}
+
+static void
+xf86libinput_stats_export_attach(InputInfoPtr pInfo)
+{
+	struct xf86libinput *driver_data = pInfo->private;
+	struct stats_export_device *d;
+	int i;
+
+	driver_data->export.slot = -1;
+
+	if (!driver_context.stats_export)
+		return;
+
+	for (i = 0; i < STATS_EXPORT_MAX_DEVICES; i++) {
+		d = stats_export_slot(i);
+		if (d->id != -1)
+			continue;
+
+		stats_export_write_begin(&d->seq);
+		memset((char*)d + sizeof(d->seq), 0, sizeof(*d) - sizeof(d->seq));
+		d->id = pInfo->dev->id;
+		strncpy(d->name, pInfo->name, sizeof(d->name) - 1);
+		stats_export_write_end(&d->seq);
+
+		driver_data->export.slot = i;
+		return;
+	}
+
+	xf86IDrvMsg(pInfo, X_WARNING,
+		    "No space left in the statistics file for this device\n");
 }
 
-static inline int
-fd_get(struct xf86libinput_driver *context,
-       const char *path)
+static void
+xf86libinput_stats_export_detach(struct xf86libinput *driver_data)
 {
-	struct serverfd *sfd;
+	struct stats_export_device *d;
 
-	xorg_list_for_each_entry(sfd, &context->server_fds, node) {
-		if (strcmp(path, sfd->path) == 0)
-			return sfd->fd;
-	}
+	if (!driver_context.stats_export || driver_data->export.slot < 0)
+		return;
 
-	return -1;
+	d = stats_export_slot(driver_data->export.slot);
+	stats_export_write_begin(&d->seq);
+	d->id = -1;
+	stats_export_write_end(&d->seq);
+
+	driver_data->export.slot = -1;
 }
 
-static inline void
-fd_pop(struct xf86libinput_driver *context, int fd)
+/* Copy the current counters into the file, once per drain */
+static void
+xf86libinput_stats_export_publish(void)
 {
-	struct serverfd *sfd;
+	struct stats_export_header *header = driver_context.stats_export;
+	struct xf86libinput *driver_data;
 
-	xorg_list_for_each_entry(sfd, &context->server_fds, node) {
-		if (fd != sfd->fd)
+	stats_export_write_begin(&header->seq);
+	header->wakeups = driver_context.drain.wakeups;
+	header->eagain = driver_context.drain.eagain;
+	memcpy(header->drain, driver_context.drain.histogram, sizeof(header->drain));
+	header->log_suppressed = driver_context.log_suppressed;
+	stats_export_write_end(&header->seq);
+
+	xorg_list_for_each_entry(driver_data, &driver_context.devices, node) {
+		struct stats_export_device *d;
+
+		if (driver_data->export.slot < 0)
 			continue;
 
-		xorg_list_del(&sfd->node);
-		free(sfd->path);
-		free(sfd);
-		break;
+		d = stats_export_slot(driver_data->export.slot);
+		stats_export_write_begin(&d->seq);
+		memcpy(d->events, driver_data->export.events, sizeof(d->events));
+		memcpy(d->latency, driver_data->export.latency, sizeof(d->latency));
+		d->suppressed_motion = driver_data->core.suppressed_motion;
+		d->throttled_motion = driver_data->flood.dropped;
+		d->config_applied = driver_data->export.config_applied;
+		stats_export_write_end(&d->seq);
 	}
 }
 
-static inline int
-fd_find(struct xf86libinput_driver *context, int fd)
+static int
+LibinputSetProperty(DeviceIntPtr dev, Atom atom, XIPropertyValuePtr val,
+                 BOOL checkonly);
+static int
+LibinputGetProperty(DeviceIntPtr dev, Atom atom);
+static void
+LibinputInitProperty(DeviceIntPtr dev);
+
+/* Calculate the matrix for the current desktop layout, see
+   translate_output_area_matrix() */
+static void
+xf86libinput_calc_matrix(struct xf86libinput *driver_data, float matrix[9])
 {
-	struct serverfd *sfd;
+	driver_data->desktop.x = screenInfo.x;
+	driver_data->desktop.y = screenInfo.y;
+	driver_data->desktop.width = screenInfo.width;
+	driver_data->desktop.height = screenInfo.height;
+
+	translate_output_area_matrix(driver_data->options.matrix,
+				     driver_data->options.output_area.x,
+				     driver_data->options.output_area.y,
+				     driver_data->options.output_area.width,
+				     driver_data->options.output_area.height,
+				     screenInfo.x, screenInfo.y,
+				     screenInfo.width, screenInfo.height,
+				     matrix);
+}
 
-	xorg_list_for_each_entry(sfd, &context->server_fds, node) {
-		if (fd == sfd->fd)
-			return fd;
+static inline BOOL
+xf86libinput_apply_matrix(InputInfoPtr pInfo)
+{
+	struct xf86libinput *driver_data = pInfo->private;
+	float matrix[9];
+
+	xf86libinput_calc_matrix(driver_data, matrix);
+
+	if (libinput_device_config_calibration_set_matrix(driver_data->device,
+							  matrix) != LIBINPUT_CONFIG_STATUS_SUCCESS) {
+		xf86IDrvMsg(pInfo, X_ERROR,
+			    "Failed to apply matrix: "
+			    "%.2f %.2f %.2f %2.f %.2f %.2f %.2f %.2f %.2f\n",
+			    matrix[0], matrix[1], matrix[2],
+			    matrix[3], matrix[4], matrix[5],
+			    matrix[6], matrix[7], matrix[8]);
+		return FALSE;
 	}
-	return -1;
+
+	return TRUE;
 }
 
-static inline unsigned int
-btn_linux2xorg(unsigned int b)
+/* Only have libinput generate the messages the server would log
+   anyway, see the verbosity levels in xf86libinput_log_handler. Called
+   from the block handler too, so verbosity changes are picked up */
+static void
+xf86libinput_update_log_priority(void)
 {
-	unsigned int button;
+	enum libinput_log_priority priority;
+	int verbosity;
 
-	switch(b) {
-	case 0: button = 0; break;
-	case BTN_LEFT: button = 1; break;
-	case BTN_MIDDLE: button = 2; break;
-	case BTN_RIGHT: button = 3; break;
-	default:
-		button = 8 + b - BTN_SIDE;
-		break;
-	}
+	if (!driver_context.libinput)
+		return;
+
+	verbosity = max(xf86GetVerbosity(), xf86GetLogVerbosity());
+
+	if (driver_context.log_priority_override)
+		priority = driver_context.log_priority_override;
+	else if (verbosity >= 10)
+		priority = LIBINPUT_LOG_PRIORITY_DEBUG;
+	else if (verbosity >= 3)
+		priority = LIBINPUT_LOG_PRIORITY_INFO;
+	else
+		priority = LIBINPUT_LOG_PRIORITY_ERROR;
+
+	if (priority == driver_context.log_priority)
+		return;
 
-	return button;
+	driver_context.log_priority = priority;
+	input_lock();
+	libinput_log_set_priority(driver_context.libinput, priority);
+	input_unlock();
 }
-static inline unsigned int
-btn_xorg2linux(unsigned int b)
+
+/* The desktop layout may change at runtime (RandR), re-calculate the
+   matrix for devices with an output area when that happens. This runs
+   from the main loop rather than for each event, so events processed
+   after the layout change use the new matrix */
+#ifdef HAVE_THREADED_INPUT
+static void
+xf86libinput_block_handler(void *data, void *timeout)
+#else
+static void
+xf86libinput_block_handler(pointer data, OSTimePtr timeout, pointer readmask)
+#endif
 {
-	unsigned int button;
+	struct xf86libinput *driver_data;
 
-	switch(b) {
-	case 0: button = 0; break;
-	case 1: button = BTN_LEFT; break;
-	case 2: button = BTN_MIDDLE; break;
-	case 3: button = BTN_RIGHT; break;
-	default:
-		button = b - 8 + BTN_SIDE;
-		break;
-	}
+	xf86libinput_update_log_priority();
+
+	if (driver_context.desktop.width == screenInfo.width &&
+	    driver_context.desktop.height == screenInfo.height &&
+	    driver_context.desktop.x == screenInfo.x &&
+	    driver_context.desktop.y == screenInfo.y)
+		return;
+
+	driver_context.desktop.x = screenInfo.x;
+	driver_context.desktop.y = screenInfo.y;
+	driver_context.desktop.width = screenInfo.width;
+	driver_context.desktop.height = screenInfo.height;
 
-	return button;
+	input_lock();
+	xorg_list_for_each_entry(driver_data, &driver_context.devices, node) {
+		if (!driver_data->device || !driver_data->has_output_area)
+			continue;
+
+		if (driver_data->desktop.width != screenInfo.width ||
+		    driver_data->desktop.height != screenInfo.height ||
+		    driver_data->desktop.x != screenInfo.x ||
+		    driver_data->desktop.y != screenInfo.y)
+			xf86libinput_apply_matrix(driver_data->pInfo);
+	}
+	input_unlock();
 }
 
-static int
-LibinputSetProperty(DeviceIntPtr dev, Atom atom, XIPropertyValuePtr val,
-                 BOOL checkonly);
+#ifdef HAVE_THREADED_INPUT
 static void
-LibinputInitProperty(DeviceIntPtr dev);
+xf86libinput_wakeup_handler(void *data, int result)
+#else
+static void
+xf86libinput_wakeup_handler(pointer data, int result, pointer readmask)
+#endif
+{
+}
 
-static inline void
-LibinputApplyConfig(DeviceIntPtr dev)
+static void
+LibinputApplyConfigMask(DeviceIntPtr dev, uint32_t mask)
 {
 	InputInfoPtr pInfo = dev->public.devicePrivate;
 	struct xf86libinput *driver_data = pInfo->private;
 	struct libinput_device *device = driver_data->device;
 	unsigned int scroll_button;
 
-	if (libinput_device_config_send_events_get_modes(device) != LIBINPUT_CONFIG_SEND_EVENTS_ENABLED &&
+	if (mask == 0)
+		return;
+
+	driver_data->export.config_applied++;
+
+	if ((mask & CONFIG_SENDEVENTS) &&
+	    libinput_device_config_send_events_get_modes(device) != LIBINPUT_CONFIG_SEND_EVENTS_ENABLED &&
 	    libinput_device_config_send_events_set_mode(device,
 							driver_data->options.sendevents) != LIBINPUT_CONFIG_STATUS_SUCCESS)
 		xf86IDrvMsg(pInfo, X_ERROR,
 			    "Failed to set SendEventsMode %u\n",
 			    driver_data->options.sendevents);
 
-	if (libinput_device_config_scroll_has_natural_scroll(device) &&
+	if ((mask & CONFIG_NATURAL_SCROLL) &&
+	    libinput_device_config_scroll_has_natural_scroll(device) &&
 	    libinput_device_config_scroll_set_natural_scroll_enabled(device,
 								     driver_data->options.natural_scrolling) != LIBINPUT_CONFIG_STATUS_SUCCESS)
 		xf86IDrvMsg(pInfo, X_ERROR,
 			    "Failed to set NaturalScrolling to %d\n",
 			    driver_data->options.natural_scrolling);
 
-	if (libinput_device_config_accel_is_available(device) &&
+	if ((mask & CONFIG_ACCEL) &&
+	    libinput_device_config_accel_is_available(device) &&
 	    libinput_device_config_accel_set_speed(device,
 						   driver_data->options.speed) != LIBINPUT_CONFIG_STATUS_SUCCESS)
 			xf86IDrvMsg(pInfo, X_ERROR,
 				    "Failed to set speed %.2f\n",
 				    driver_data->options.speed);
-	if (libinput_device_config_tap_get_finger_count(device) > 0 &&
+	if ((mask & CONFIG_TAP) &&
+	    libinput_device_config_tap_get_finger_count(device) > 0 &&
 	    libinput_device_config_tap_set_enabled(device,
 						   driver_data->options.tapping) != LIBINPUT_CONFIG_STATUS_SUCCESS)
 		xf86IDrvMsg(pInfo, X_ERROR,
 			    "Failed to set Tapping to %d\n",
 			    driver_data->options.tapping);
 
-	if (libinput_device_config_tap_get_finger_count(device) > 0 &&
+	if ((mask & CONFIG_TAP_DRAG_LOCK) &&
+	    libinput_device_config_tap_get_finger_count(device) > 0 &&
 	    libinput_device_config_tap_set_drag_lock_enabled(device,
 							     driver_data->options.tap_drag_lock) != LIBINPUT_CONFIG_STATUS_SUCCESS)
 		xf86IDrvMsg(pInfo, X_ERROR,
 			    "Failed to set Tapping DragLock to %d\n",
 			    driver_data->options.tap_drag_lock);
 
-	if (libinput_device_config_calibration_has_matrix(device) &&
-	    libinput_device_config_calibration_set_matrix(device,
-							  driver_data->options.matrix) != LIBINPUT_CONFIG_STATUS_SUCCESS)
-		xf86IDrvMsg(pInfo, X_ERROR,
-			    "Failed to apply matrix: "
-			    "%.2f %.2f %.2f %2.f %.2f %.2f %.2f %.2f %.2f\n",
-			    driver_data->options.matrix[0], driver_data->options.matrix[1],
-			    driver_data->options.matrix[2], driver_data->options.matrix[3],
-			    driver_data->options.matrix[4], driver_data->options.matrix[5],
-			    driver_data->options.matrix[6], driver_data->options.matrix[7],
-			    driver_data->options.matrix[8]);
+	if ((mask & CONFIG_CALIBRATION) &&
+	    libinput_device_config_calibration_has_matrix(device))
+		xf86libinput_apply_matrix(pInfo);
 
-	if (libinput_device_config_left_handed_is_available(device) &&
+	if ((mask & CONFIG_LEFT_HANDED) &&
+	    libinput_device_config_left_handed_is_available(device) &&
 	    libinput_device_config_left_handed_set(device,
 						   driver_data->options.left_handed) != LIBINPUT_CONFIG_STATUS_SUCCESS)
 		xf86IDrvMsg(pInfo, X_ERROR,
 			    "Failed to set LeftHanded to %d\n",
 			    driver_data->options.left_handed);
 
-	if (libinput_device_config_scroll_set_method(device,
+	if ((mask & CONFIG_SCROLL_METHOD) &&
+	    libinput_device_config_scroll_set_method(device,
 						     driver_data->options.scroll_method) != LIBINPUT_CONFIG_STATUS_SUCCESS) {
 		const char *method;
 
@@ -307,7 +1704,8 @@ LibinputApplyConfig(DeviceIntPtr dev)
 			    method);
 	}
 
-	if (libinput_device_config_scroll_get_methods(device) & LIBINPUT_CONFIG_SCROLL_ON_BUTTON_DOWN) {
+	if ((mask & CONFIG_SCROLL_BUTTON) &&
+	    libinput_device_config_scroll_get_methods(device) & LIBINPUT_CONFIG_SCROLL_ON_BUTTON_DOWN) {
 		scroll_button = btn_xorg2linux(driver_data->options.scroll_button);
 		if (libinput_device_config_scroll_set_button(device, scroll_button) != LIBINPUT_CONFIG_STATUS_SUCCESS)
 			xf86IDrvMsg(pInfo, X_ERROR,
@@ -315,7 +1713,8 @@ LibinputApplyConfig(DeviceIntPtr dev)
 				    driver_data->options.scroll_button);
 	}
 
-	if (libinput_device_config_click_set_method(device,
+	if ((mask & CONFIG_CLICK_METHOD) &&
+	    libinput_device_config_click_set_method(device,
 						    driver_data->options.click_method) != LIBINPUT_CONFIG_STATUS_SUCCESS) {
 		const char *method;
 
@@ -332,12 +1731,62 @@ LibinputApplyConfig(DeviceIntPtr dev)
 			    method);
 	}
 
-	if (libinput_device_config_middle_emulation_is_available(device) &&
+	if ((mask & CONFIG_MIDDLE_EMULATION) &&
+	    libinput_device_config_middle_emulation_is_available(device) &&
 	    libinput_device_config_middle_emulation_set_enabled(device,
 								driver_data->options.middle_emulation) != LIBINPUT_CONFIG_STATUS_SUCCESS)
 		xf86IDrvMsg(pInfo, X_ERROR,
 			    "Failed to set MiddleEmulation to %d\n",
 			    driver_data->options.middle_emulation);
+
+	flight_recorder_config(dev->id,
+			       (!!driver_data->options.tapping) |
+			       (!!driver_data->options.tap_drag_lock) << 1 |
+			       (!!driver_data->options.natural_scrolling) << 2 |
+			       (!!driver_data->options.left_handed) << 3 |
+			       (!!driver_data->options.middle_emulation) << 4 |
+			       (driver_data->options.sendevents & 0xf) << 8 |
+			       (driver_data->options.scroll_method & 0xf) << 12 |
+			       (driver_data->options.click_method & 0xf) << 16,
+			       driver_data->options.speed);
+}
+
+static inline void
+LibinputApplyConfig(DeviceIntPtr dev)
+{
+	InputInfoPtr pInfo = dev->public.devicePrivate;
+	struct xf86libinput *driver_data = pInfo->private;
+
+	driver_data->config_dirty = 0;
+	LibinputApplyConfigMask(dev, CONFIG_ALL);
+}
+
+/* Stop kinetic scrolling, see xf86libinput_kinetic_timer() */
+static inline void
+xf86libinput_kinetic_cancel(struct xf86libinput *driver_data)
+{
+	if (!driver_data->kinetic.active)
+		return;
+
+	driver_data->kinetic.active = FALSE;
+	driver_context.kinetic_devices--;
+	TimerCancel(driver_data->kinetic.timer);
+}
+
+/* Post all key events collected in burst mode, in order */
+static void
+xf86libinput_flush_keys(InputInfoPtr pInfo)
+{
+	DeviceIntPtr dev = pInfo->dev;
+	struct xf86libinput *driver_data = pInfo->private;
+	int i;
+
+	for (i = 0; i < driver_data->burst.nkeys; i++)
+		xf86PostKeyboardEvent(dev,
+				      driver_data->burst.keys[i].key,
+				      driver_data->burst.keys[i].is_press);
+
+	driver_data->burst.nkeys = 0;
 }
 
 static int
@@ -371,11 +1820,32 @@ xf86libinput_on(DeviceIntPtr dev)
 	if (driver_context.device_enabled_count == 0) {
 		/* Can't use xf86AddEnabledDevice on an epollfd */
 		AddEnabledDevice(pInfo->fd);
+
+		driver_context.desktop.x = screenInfo.x;
+		driver_context.desktop.y = screenInfo.y;
+		driver_context.desktop.width = screenInfo.width;
+		driver_context.desktop.height = screenInfo.height;
+		RegisterBlockAndWakeupHandlers(xf86libinput_block_handler,
+					       xf86libinput_wakeup_handler,
+					       NULL);
 	}
 
 	driver_context.device_enabled_count++;
 	dev->public.on = TRUE;
 
+	translate_device_reset(&driver_data->core);
+	if (driver_data->flood.threshold > 0) {
+		driver_data->flood.count = 0;
+		driver_data->flood.rate = 0;
+		driver_data->flood.over = 0;
+		driver_data->flood.under = 0;
+		driver_data->flood.throttled = FALSE;
+		driver_data->flood.window_start = xf86libinput_now_us();
+	}
+	driver_data->leds.applied = -1;
+
+	xf86libinput_stats_export_attach(pInfo);
+
 	LibinputApplyConfig(dev);
 
 	return Success;
@@ -387,8 +1857,16 @@ xf86libinput_off(DeviceIntPtr dev)
 	InputInfoPtr pInfo = dev->public.devicePrivate;
 	struct xf86libinput *driver_data = pInfo->private;
 
+	/* keys read in the last burst must not get lost, their releases
+	   may be among them */
+	xf86libinput_flush_keys(pInfo);
+	xf86libinput_ratelimit_flush_device(pInfo);
+
 	if (--driver_context.device_enabled_count == 0) {
 		RemoveEnabledDevice(pInfo->fd);
+		RemoveBlockAndWakeupHandlers(xf86libinput_block_handler,
+					     xf86libinput_wakeup_handler,
+					     NULL);
 	}
 
 	if (use_server_fd(pInfo)) {
@@ -399,6 +1877,21 @@ xf86libinput_off(DeviceIntPtr dev)
 	}
 
 	dev->public.on = FALSE;
+	driver_data->leds.needs_update = FALSE;
+	xf86libinput_stats_export_detach(driver_data);
+	driver_data->axis.pending = FALSE;
+	xf86libinput_kinetic_cancel(driver_data);
+	driver_data->kinetic.last_time = 0;
+
+	if (driver_data->core.suppressed_motion > 0)
+		xf86IDrvMsgVerb(pInfo, X_INFO, 7,
+				"Suppressed %llu duplicate motion events\n",
+				(unsigned long long)driver_data->core.suppressed_motion);
+	if (driver_data->axis.events > driver_data->axis.posted)
+		xf86IDrvMsgVerb(pInfo, X_INFO, 7,
+				"Merged %llu axis events into %llu\n",
+				(unsigned long long)driver_data->axis.events,
+				(unsigned long long)driver_data->axis.posted);
 
 	libinput_device_set_user_data(driver_data->device, NULL);
 	libinput_path_remove_device(driver_data->device);
@@ -413,16 +1906,6 @@ xf86libinput_ptr_ctl(DeviceIntPtr dev, PtrCtrl *ctl)
 {
 }
 
-static void
-init_button_map(unsigned char *btnmap, size_t size)
-{
-	int i;
-
-	memset(btnmap, 0, size);
-	for (i = 0; i < size; i++)
-		btnmap[i] = i;
-}
-
 static void
 init_button_labels(Atom *labels, size_t size)
 {
@@ -493,8 +1976,8 @@ xf86libinput_init_pointer(InputInfoPtr pInfo)
 			           XIGetKnownProperty(AXIS_LABEL_PROP_REL_Y),
 				   min, max, res * 1000, 0, res * 1000, Relative);
 
-	SetScrollValuator(dev, 2, SCROLL_TYPE_HORIZONTAL, driver_data->scroll.hdist, 0);
-	SetScrollValuator(dev, 3, SCROLL_TYPE_VERTICAL, driver_data->scroll.vdist, 0);
+	SetScrollValuator(dev, 2, SCROLL_TYPE_HORIZONTAL, driver_data->core.scroll.increment, 0);
+	SetScrollValuator(dev, 3, SCROLL_TYPE_VERTICAL, driver_data->core.scroll.increment, 0);
 
 	return Success;
 }
@@ -540,13 +2023,40 @@ xf86libinput_init_pointer_absolute(InputInfoPtr pInfo)
 			           XIGetKnownProperty(AXIS_LABEL_PROP_ABS_Y),
 				   min, max, res * 1000, 0, res * 1000, Absolute);
 
-	SetScrollValuator(dev, 2, SCROLL_TYPE_HORIZONTAL, driver_data->scroll.hdist, 0);
-	SetScrollValuator(dev, 3, SCROLL_TYPE_VERTICAL, driver_data->scroll.vdist, 0);
+	SetScrollValuator(dev, 2, SCROLL_TYPE_HORIZONTAL, driver_data->core.scroll.increment, 0);
+	SetScrollValuator(dev, 3, SCROLL_TYPE_VERTICAL, driver_data->core.scroll.increment, 0);
 
 	driver_data->has_abs = TRUE;
 
 	return Success;
 }
+/* A lock key toggle calls kbd_ctrl once for every keyboard. Instead of
+   writing to each device immediately, we collect the updates and flush
+   them all at once when the timer fires */
+static CARD32
+xf86libinput_led_timer(OsTimerPtr timer, CARD32 now, pointer data)
+{
+	struct xf86libinput *driver_data;
+
+	input_lock();
+	xorg_list_for_each_entry(driver_data, &driver_context.devices, node) {
+		if (!driver_data->leds.needs_update)
+			continue;
+
+		driver_data->leds.needs_update = FALSE;
+		if (!driver_data->device ||
+		    driver_data->leds.pending == driver_data->leds.applied)
+			continue;
+
+		libinput_device_led_update(driver_data->device,
+					   driver_data->leds.pending);
+		driver_data->leds.applied = driver_data->leds.pending;
+	}
+	input_unlock();
+
+	return 0;
+}
+
 static void
 xf86libinput_kbd_ctrl(DeviceIntPtr device, KeybdCtrl *ctrl)
 {
@@ -572,7 +2082,18 @@ xf86libinput_kbd_ctrl(DeviceIntPtr device, KeybdCtrl *ctrl)
 	    i++;
     }
 
-    libinput_device_led_update(ldevice, leds);
+    if (!ldevice)
+	    return;
+
+    if (!driver_data->leds.needs_update && (int)leds == driver_data->leds.applied)
+	    return;
+
+    driver_data->leds.pending = leds;
+    if (!driver_data->leds.needs_update) {
+	    driver_data->leds.needs_update = TRUE;
+	    driver_context.led_timer = TimerSet(driver_context.led_timer, 0, 1,
+						xf86libinput_led_timer, NULL);
+    }
 }
 
 static void
@@ -617,7 +2138,7 @@ xf86libinput_init_touch(InputInfoPtr pInfo)
 	Atom axislabels[TOUCHPAD_NUM_AXES];
 	int nbuttons = 7;
 
-	init_button_map(btnmap, ARRAY_SIZE(btnmap));
+	translate_init_button_map(btnmap, ARRAY_SIZE(btnmap));
 	init_button_labels(btnlabels, ARRAY_SIZE(btnlabels));
 	init_axis_labels(axislabels, ARRAY_SIZE(axislabels));
 
@@ -666,11 +2187,12 @@ xf86libinput_init(DeviceIntPtr dev)
 
 	LibinputApplyConfig(dev);
 	LibinputInitProperty(dev);
-	XIRegisterPropertyHandler(dev, LibinputSetProperty, NULL, NULL);
+	XIRegisterPropertyHandler(dev, LibinputSetProperty, LibinputGetProperty, NULL);
 
 	/* unref the device now, because we'll get a new ref during
 	   DEVICE_ON */
 	libinput_device_unref(device);
+	driver_data->device = NULL;
 
 	return 0;
 }
@@ -700,133 +2222,498 @@ xf86libinput_device_control(DeviceIntPtr dev, int mode)
 			break;
 	}
 
-	return rc;
+	return rc;
+}
+
+/* Returns TRUE if a motion event is to be dropped because the device
+   is throttled. One in every flood.decimation events of each stream is
+   kept. Relative motion, absolute motion and each touch slot are
+   separate streams, so interleaved touches can't starve one another
+   when the decimation divides the number of touches */
+static inline BOOL
+xf86libinput_flood_drop_motion(struct xf86libinput *driver_data,
+			       unsigned int stream)
+{
+	if (driver_context.flood_devices == 0 ||
+	    !driver_data->flood.throttled)
+		return FALSE;
+
+	if (++driver_data->flood.seq[stream] % driver_data->flood.decimation == 0)
+		return FALSE;
+
+	driver_data->flood.dropped++;
+	return TRUE;
+}
+
+/* Called once per drain for every device with a flood threshold. The
+   event rate is calculated over windows of at least FLOOD_WINDOW_US,
+   the device is throttled after FLOOD_STRIKES windows over its
+   threshold and released after as many windows below it. */
+static void
+xf86libinput_flood_update(InputInfoPtr pInfo, uint64_t now)
+{
+	struct xf86libinput *driver_data = pInfo->private;
+	uint64_t elapsed = now - driver_data->flood.window_start;
+	unsigned int threshold = driver_data->flood.threshold;
+	unsigned int rate;
+
+	if (elapsed < FLOOD_WINDOW_US)
+		return;
+
+	rate = driver_data->flood.count * 1000000ULL / elapsed;
+	driver_data->flood.rate = rate;
+	driver_data->flood.count = 0;
+	driver_data->flood.window_start = now;
+
+	if (rate > threshold) {
+		driver_data->flood.over = min(driver_data->flood.over + 1, FLOOD_STRIKES);
+		driver_data->flood.under = 0;
+	} else {
+		driver_data->flood.under = min(driver_data->flood.under + 1, FLOOD_STRIKES);
+		driver_data->flood.over = 0;
+	}
+
+	if (driver_data->flood.over == FLOOD_STRIKES) {
+		/* the rate counts all events, so this leaves roughly
+		   threshold events/s */
+		driver_data->flood.decimation = (rate + threshold - 1)/threshold;
+
+		if (driver_data->flood.throttled)
+			return;
+
+		driver_data->flood.throttled = TRUE;
+		if (!driver_data->flood.logged) {
+			xf86IDrvMsg(pInfo, X_WARNING,
+				    "Device sends %u events/s, more than its FloodThreshold of %u. "
+				    "Throttling motion events\n",
+				    rate, threshold);
+			driver_data->flood.logged = TRUE;
+		} else {
+			xf86IDrvMsgVerb(pInfo, X_INFO, 7,
+					"Throttling motion events (%u events/s)\n",
+					rate);
+		}
+	} else if (driver_data->flood.throttled &&
+		   driver_data->flood.under == FLOOD_STRIKES) {
+		driver_data->flood.throttled = FALSE;
+		xf86IDrvMsgVerb(pInfo, X_INFO, 7,
+				"No longer throttling motion events (%u events/s)\n",
+				rate);
+	}
+}
+
+/* Post the event described by a translation record */
+static void
+xf86libinput_post(InputInfoPtr pInfo, const struct translate_post *post)
+{
+	DeviceIntPtr dev = pInfo->dev;
+	struct xf86libinput *driver_data = pInfo->private;
+	ValuatorMask *mask = driver_data->valuators;
+	int i;
+
+	if (post->type != TRANSLATE_POST_BUTTON &&
+	    post->type != TRANSLATE_POST_KEY) {
+		valuator_mask_zero(mask);
+		for (i = 0; i < TRANSLATE_NUM_VALUATORS; i++) {
+			if (post->mask & (1 << i))
+				valuator_mask_set_double(mask, i, post->values[i]);
+		}
+#if HAVE_VMASK_UNACCEL
+		if (post->has_unaccel) {
+			valuator_mask_set_unaccelerated(mask, 0,
+							post->values[0],
+							post->unaccel[0]);
+			valuator_mask_set_unaccelerated(mask, 1,
+							post->values[1],
+							post->unaccel[1]);
+		}
+#endif
+	}
+
+	switch (post->type) {
+		case TRANSLATE_POST_NONE:
+			break;
+		case TRANSLATE_POST_MOTION:
+			xf86PostMotionEventM(dev, Relative, mask);
+			break;
+		case TRANSLATE_POST_MOTION_ABSOLUTE:
+			xf86PostMotionEventM(dev, Absolute, mask);
+			break;
+		case TRANSLATE_POST_BUTTON:
+			xf86PostButtonEvent(dev, Relative, post->code,
+					    post->state, 0, 0);
+			break;
+		case TRANSLATE_POST_KEY:
+			if (driver_data->burst.keys) {
+				int idx = driver_data->burst.nkeys++;
+
+				driver_data->burst.keys[idx].key = post->code;
+				driver_data->burst.keys[idx].is_press = post->state;
+				if (driver_data->burst.nkeys == KEY_BURST_SIZE)
+					xf86libinput_flush_keys(pInfo);
+				break;
+			}
+			xf86PostKeyboardEvent(dev, post->code, post->state);
+			break;
+		case TRANSLATE_POST_TOUCH: {
+			int type;
+
+			switch (post->state) {
+				case TRANSLATE_TOUCH_BEGIN: type = XI_TouchBegin; break;
+				case TRANSLATE_TOUCH_END: type = XI_TouchEnd; break;
+				default: type = XI_TouchUpdate; break;
+			}
+			xf86PostTouchEvent(dev, post->code, type, 0, mask);
+			break;
+		}
+	}
+}
+
+static void
+xf86libinput_handle_motion(InputInfoPtr pInfo, struct libinput_event_pointer *event)
+{
+	struct xf86libinput *driver_data = pInfo->private;
+	struct translate_post post;
+	double dx, dy, udx, udy;
+
+	dx = libinput_event_pointer_get_dx(event);
+	dy = libinput_event_pointer_get_dy(event);
+	udx = libinput_event_pointer_get_dx_unaccelerated(event);
+	udy = libinput_event_pointer_get_dy_unaccelerated(event);
+
+	if (driver_context.flood_devices > 0) {
+		dx += driver_data->flood.dx;
+		dy += driver_data->flood.dy;
+		udx += driver_data->flood.dx_unaccel;
+		udy += driver_data->flood.dy_unaccel;
+
+		if (xf86libinput_flood_drop_motion(driver_data,
+						   FLOOD_STREAM_MOTION)) {
+			driver_data->flood.dx = dx;
+			driver_data->flood.dy = dy;
+			driver_data->flood.dx_unaccel = udx;
+			driver_data->flood.dy_unaccel = udy;
+			return;
+		}
+
+		driver_data->flood.dx = 0;
+		driver_data->flood.dy = 0;
+		driver_data->flood.dx_unaccel = 0;
+		driver_data->flood.dy_unaccel = 0;
+	}
+
+	if (translate_motion(&driver_data->core, dx, dy, udx, udy, &post))
+		xf86libinput_post(pInfo, &post);
+}
+
+static void
+xf86libinput_handle_absmotion(InputInfoPtr pInfo, struct libinput_event_pointer *event)
+{
+	struct xf86libinput *driver_data = pInfo->private;
+	struct translate_post post;
+	double x, y;
+
+	if (!driver_data->has_abs) {
+		static struct ratelimit rl = RATELIMIT_INIT(5000, 5);
+
+		xf86libinput_log_ratelimit(pInfo, &rl, X_ERROR,
+					   "Discarding absolute event from relative device. "
+					   "Please file a bug\n");
+		return;
+	}
+
+	if (xf86libinput_flood_drop_motion(driver_data, FLOOD_STREAM_ABSOLUTE))
+		return;
+
+	x = libinput_event_pointer_get_absolute_x_transformed(event, TOUCH_AXIS_MAX);
+	y = libinput_event_pointer_get_absolute_y_transformed(event, TOUCH_AXIS_MAX);
+
+	if (translate_motion_absolute(&driver_data->core, x, y, &post))
+		xf86libinput_post(pInfo, &post);
+}
+
+static void
+xf86libinput_handle_button(InputInfoPtr pInfo, struct libinput_event_pointer *event)
+{
+	struct xf86libinput *driver_data = pInfo->private;
+	struct translate_post post;
+	BOOL is_press;
+
+	is_press = (libinput_event_pointer_get_button_state(event) == LIBINPUT_BUTTON_STATE_PRESSED);
+	if (translate_button(&driver_data->core,
+			     libinput_event_pointer_get_button(event),
+			     is_press, &post))
+		xf86libinput_post(pInfo, &post);
+}
+
+static void
+xf86libinput_handle_key(InputInfoPtr pInfo, struct libinput_event_keyboard *event)
+{
+	struct xf86libinput *driver_data = pInfo->private;
+	struct translate_post post;
+	BOOL is_press;
+
+	is_press = (libinput_event_keyboard_get_key_state(event) == LIBINPUT_KEY_STATE_PRESSED);
+	if (translate_key(&driver_data->core,
+			  libinput_event_keyboard_get_key(event),
+			  is_press, &post))
+		xf86libinput_post(pInfo, &post);
+}
+
+static inline void
+xf86libinput_get_axis(struct libinput_event_pointer *event,
+		      enum libinput_pointer_axis axis,
+		      enum libinput_pointer_axis_source source,
+		      double *value, double *discrete)
+{
+	*value = NAN;
+	*discrete = NAN;
+
+	if (!libinput_event_pointer_has_axis(event, axis))
+		return;
+
+	if (source == LIBINPUT_POINTER_AXIS_SOURCE_WHEEL)
+		*discrete = libinput_event_pointer_get_axis_value_discrete(event, axis);
+	else
+		*value = libinput_event_pointer_get_axis_value(event, axis);
 }
 
-static void
-xf86libinput_handle_motion(InputInfoPtr pInfo, struct libinput_event_pointer *event)
+/*
+   Kinetic scrolling: while the fingers scroll we track their velocity,
+   when libinput sends the axis stop event (a value of 0) we keep
+   scrolling from a timer with the velocity decaying exponentially,
+   v(t) = v0 * e^(-t/tc). Each post adds the distance travelled since the
+   previous one, so the total does not depend on the interval. Any new
+   event from the device stops it.
+ */
+static CARD32
+xf86libinput_kinetic_timer(OsTimerPtr timer, CARD32 now, pointer data)
 {
-	DeviceIntPtr dev = pInfo->dev;
+	InputInfoPtr pInfo = data;
 	struct xf86libinput *driver_data = pInfo->private;
-	ValuatorMask *mask = driver_data->valuators;
-	double x, y;
+	struct translate_post post;
+	double tc = driver_data->kinetic.time_constant;
+	double t, dist;
+	CARD32 next = driver_data->kinetic.interval;
+
+	input_lock();
 
-	x = libinput_event_pointer_get_dx(event);
-	y = libinput_event_pointer_get_dy(event);
+	if (!driver_data->kinetic.active) {
+		next = 0;
+		goto out;
+	}
+
+	t = (CARD32)(now - driver_data->kinetic.start);
+	dist = tc * (exp(-driver_data->kinetic.elapsed/tc) - exp(-t/tc));
+	driver_data->kinetic.elapsed = t;
+
+	if (translate_axis(&driver_data->core,
+			   LIBINPUT_POINTER_AXIS_SOURCE_FINGER,
+			   driver_data->kinetic.vy0 != 0 ? driver_data->kinetic.vy0 * dist : NAN,
+			   NAN,
+			   driver_data->kinetic.vx0 != 0 ? driver_data->kinetic.vx0 * dist : NAN,
+			   NAN,
+			   &post))
+		xf86libinput_post(pInfo, &post);
+
+	if (max(fabs(driver_data->kinetic.vx0),
+		fabs(driver_data->kinetic.vy0)) * exp(-t/tc) < KINETIC_MIN_SPEED) {
+		driver_data->kinetic.active = FALSE;
+		driver_context.kinetic_devices--;
+		next = 0;
+	}
 
-	valuator_mask_zero(mask);
+out:
+	input_unlock();
 
-#if HAVE_VMASK_UNACCEL
-	{
-		double ux, uy;
+	return next;
+}
 
-		ux = libinput_event_pointer_get_dx_unaccelerated(event);
-		uy = libinput_event_pointer_get_dy_unaccelerated(event);
+/* Called for every finger axis event. Returns TRUE if this is the
+   axis stop event and coasting started */
+static BOOL
+xf86libinput_kinetic_track(InputInfoPtr pInfo,
+			   uint32_t time,
+			   double vert, double horiz)
+{
+	struct xf86libinput *driver_data = pInfo->private;
+	uint32_t dt = time - driver_data->kinetic.last_time;
+	BOOL is_stop = (isnan(vert) || vert == 0) && (isnan(horiz) || horiz == 0);
+
+	if (driver_data->kinetic.last_time == 0 || dt > KINETIC_MAX_GAP) {
+		/* fingers rested before lifting, or a new scroll */
+		driver_data->kinetic.vx = 0;
+		driver_data->kinetic.vy = 0;
+		driver_data->kinetic.last_time = time;
+		return FALSE;
+	}
 
-		valuator_mask_set_unaccelerated(mask, 0, x, ux);
-		valuator_mask_set_unaccelerated(mask, 1, y, uy);
+	driver_data->kinetic.last_time = time;
+
+	if (is_stop) {
+		driver_data->kinetic.last_time = 0;
+		driver_data->kinetic.vx0 = fabs(driver_data->kinetic.vx) >= KINETIC_MIN_SPEED ?
+					   driver_data->kinetic.vx : 0;
+		driver_data->kinetic.vy0 = fabs(driver_data->kinetic.vy) >= KINETIC_MIN_SPEED ?
+					   driver_data->kinetic.vy : 0;
+		if (driver_data->kinetic.vx0 == 0 && driver_data->kinetic.vy0 == 0)
+			return FALSE;
+
+		if (!driver_data->kinetic.active)
+			driver_context.kinetic_devices++;
+		driver_data->kinetic.active = TRUE;
+		driver_data->kinetic.start = GetTimeInMillis();
+		driver_data->kinetic.elapsed = 0;
+		driver_data->kinetic.timer = TimerSet(driver_data->kinetic.timer, 0,
+						      driver_data->kinetic.interval,
+						      xf86libinput_kinetic_timer,
+						      pInfo);
+		return TRUE;
 	}
-#else
-	valuator_mask_set_double(mask, 0, x);
-	valuator_mask_set_double(mask, 1, y);
-#endif
-	xf86PostMotionEventM(dev, Relative, mask);
+
+	if (dt == 0)
+		dt = 1;
+
+	/* smooth over the last few events */
+	driver_data->kinetic.vx = 0.6 * (isnan(horiz) ? 0 : horiz/dt) +
+				  0.4 * driver_data->kinetic.vx;
+	driver_data->kinetic.vy = 0.6 * (isnan(vert) ? 0 : vert/dt) +
+				  0.4 * driver_data->kinetic.vy;
+
+	return FALSE;
 }
 
+/* Change the scroll distances, i.e. the scroll motion of one wheel
+   click. The valuator increment announced to clients stays the same,
+   translate_axis() scales the scroll values to it instead. Must be
+   called with the input lock held */
 static void
-xf86libinput_handle_absmotion(InputInfoPtr pInfo, struct libinput_event_pointer *event)
+xf86libinput_set_scroll_distance(InputInfoPtr pInfo, int vdist, int hdist)
 {
-	DeviceIntPtr dev = pInfo->dev;
 	struct xf86libinput *driver_data = pInfo->private;
-	ValuatorMask *mask = driver_data->valuators;
-	double x, y;
 
-	if (!driver_data->has_abs) {
-		xf86IDrvMsg(pInfo, X_ERROR,
-			    "Discarding absolute event from relative device. "
-			    "Please file a bug\n");
-		return;
-	}
+	driver_data->core.scroll.vdist = vdist;
+	driver_data->core.scroll.hdist = hdist;
+}
 
-	x = libinput_event_pointer_get_absolute_x_transformed(event, TOUCH_AXIS_MAX);
-	y = libinput_event_pointer_get_absolute_y_transformed(event, TOUCH_AXIS_MAX);
+/* Without a ScrollDistance, use the value libinput gives for one click
+   of the wheel, e.g. 15 degrees, rounded to an integer */
+static inline int
+xf86libinput_wheel_click_distance(struct libinput_event_pointer *event,
+				  enum libinput_pointer_axis axis,
+				  int dist)
+{
+	double discrete = libinput_event_pointer_get_axis_value_discrete(event, axis);
+	double value = libinput_event_pointer_get_axis_value(event, axis);
 
-	valuator_mask_zero(mask);
-	valuator_mask_set_double(mask, 0, x);
-	valuator_mask_set_double(mask, 1, y);
+	if (discrete == 0)
+		return dist;
 
-	xf86PostMotionEventM(dev, Absolute, mask);
+	return max(1, min(SCROLL_DISTANCE_MAX, lround(fabs(value/discrete))));
 }
 
 static void
-xf86libinput_handle_button(InputInfoPtr pInfo, struct libinput_event_pointer *event)
+xf86libinput_derive_scroll_distance(InputInfoPtr pInfo,
+				    struct libinput_event_pointer *event)
 {
-	DeviceIntPtr dev = pInfo->dev;
-	int button;
-	int is_press;
+	struct xf86libinput *driver_data = pInfo->private;
+	int vdist = driver_data->core.scroll.vdist,
+	    hdist = driver_data->core.scroll.hdist;
+
+	if (driver_data->scroll_auto_vert &&
+	    libinput_event_pointer_has_axis(event, LIBINPUT_POINTER_AXIS_SCROLL_VERTICAL)) {
+		vdist = xf86libinput_wheel_click_distance(event,
+							  LIBINPUT_POINTER_AXIS_SCROLL_VERTICAL,
+							  vdist);
+		driver_data->scroll_auto_vert = FALSE;
+	}
 
-	button = btn_linux2xorg(libinput_event_pointer_get_button(event));
-	is_press = (libinput_event_pointer_get_button_state(event) == LIBINPUT_BUTTON_STATE_PRESSED);
-	xf86PostButtonEvent(dev, Relative, button, is_press, 0, 0);
+	if (driver_data->scroll_auto_horiz &&
+	    libinput_event_pointer_has_axis(event, LIBINPUT_POINTER_AXIS_SCROLL_HORIZONTAL)) {
+		hdist = xf86libinput_wheel_click_distance(event,
+							  LIBINPUT_POINTER_AXIS_SCROLL_HORIZONTAL,
+							  hdist);
+		driver_data->scroll_auto_horiz = FALSE;
+	}
+
+	xf86libinput_set_scroll_distance(pInfo, vdist, hdist);
+}
+
+/* NAN is a missing axis, see translate_axis() */
+static inline double
+axis_sum(double a, double b)
+{
+	if (isnan(a))
+		return b;
+	if (isnan(b))
+		return a;
+	return a + b;
 }
 
 static void
-xf86libinput_handle_key(InputInfoPtr pInfo, struct libinput_event_keyboard *event)
+xf86libinput_flush_axis(InputInfoPtr pInfo)
 {
-	DeviceIntPtr dev = pInfo->dev;
-	int is_press;
-	int key = libinput_event_keyboard_get_key(event);
+	struct xf86libinput *driver_data = pInfo->private;
+	struct translate_post post;
 
-	key += XORG_KEYCODE_OFFSET;
+	driver_data->axis.pending = FALSE;
 
-	is_press = (libinput_event_keyboard_get_key_state(event) == LIBINPUT_KEY_STATE_PRESSED);
-	xf86PostKeyboardEvent(dev, key, is_press);
+	if (translate_axis(&driver_data->core, driver_data->axis.source,
+			   driver_data->axis.vert, driver_data->axis.vert_discrete,
+			   driver_data->axis.horiz, driver_data->axis.horiz_discrete,
+			   &post)) {
+		xf86libinput_post(pInfo, &post);
+		driver_data->axis.posted++;
+	}
 }
 
 static void
 xf86libinput_handle_axis(InputInfoPtr pInfo, struct libinput_event_pointer *event)
 {
-	DeviceIntPtr dev = pInfo->dev;
 	struct xf86libinput *driver_data = pInfo->private;
-	ValuatorMask *mask = driver_data->valuators;
-	double value;
-	enum libinput_pointer_axis axis;
 	enum libinput_pointer_axis_source source;
-
-	valuator_mask_zero(mask);
+	double vert, vert_discrete, horiz, horiz_discrete;
 
 	source = libinput_event_pointer_get_axis_source(event);
-	switch(source) {
-		case LIBINPUT_POINTER_AXIS_SOURCE_FINGER:
-		case LIBINPUT_POINTER_AXIS_SOURCE_WHEEL:
-		case LIBINPUT_POINTER_AXIS_SOURCE_CONTINUOUS:
-			break;
-		default:
-			return;
-	}
 
-	axis = LIBINPUT_POINTER_AXIS_SCROLL_VERTICAL;
-	if (libinput_event_pointer_has_axis(event, axis)) {
-		if (source == LIBINPUT_POINTER_AXIS_SOURCE_WHEEL) {
-			value = libinput_event_pointer_get_axis_value_discrete(event, axis);
-			value *=  driver_data->scroll.vdist;
-		} else {
-			value = libinput_event_pointer_get_axis_value(event, axis);
-		}
-		valuator_mask_set_double(mask, 3, value);
-	}
-	axis = LIBINPUT_POINTER_AXIS_SCROLL_HORIZONTAL;
-	if (libinput_event_pointer_has_axis(event, axis)) {
-		if (source == LIBINPUT_POINTER_AXIS_SOURCE_WHEEL) {
-			value = libinput_event_pointer_get_axis_value_discrete(event, axis);
-			value *=  driver_data->scroll.hdist;
-		} else {
-			value = libinput_event_pointer_get_axis_value(event, axis);
-		}
-		valuator_mask_set_double(mask, 2, value);
+	if (source == LIBINPUT_POINTER_AXIS_SOURCE_WHEEL &&
+	    (driver_data->scroll_auto_vert || driver_data->scroll_auto_horiz))
+		xf86libinput_derive_scroll_distance(pInfo, event);
+
+	xf86libinput_get_axis(event, LIBINPUT_POINTER_AXIS_SCROLL_VERTICAL,
+			      source, &vert, &vert_discrete);
+	xf86libinput_get_axis(event, LIBINPUT_POINTER_AXIS_SCROLL_HORIZONTAL,
+			      source, &horiz, &horiz_discrete);
+
+	if (driver_data->kinetic.enabled &&
+	    source == LIBINPUT_POINTER_AXIS_SOURCE_FINGER)
+		xf86libinput_kinetic_track(pInfo,
+					   libinput_event_pointer_get_time(event),
+					   vert, horiz);
+
+	driver_data->axis.events++;
+
+	/* Merge with the previous event if it was from the same source,
+	   it is posted when another event comes in or at the end of
+	   xf86libinput_read_input() */
+	if (driver_data->axis.pending && driver_data->axis.source != source)
+		xf86libinput_flush_axis(pInfo);
+
+	if (driver_data->axis.pending) {
+		driver_data->axis.vert = axis_sum(driver_data->axis.vert, vert);
+		driver_data->axis.vert_discrete = axis_sum(driver_data->axis.vert_discrete,
+							   vert_discrete);
+		driver_data->axis.horiz = axis_sum(driver_data->axis.horiz, horiz);
+		driver_data->axis.horiz_discrete = axis_sum(driver_data->axis.horiz_discrete,
+							    horiz_discrete);
+	} else {
+		driver_data->axis.pending = TRUE;
+		driver_data->axis.source = source;
+		driver_data->axis.vert = vert;
+		driver_data->axis.vert_discrete = vert_discrete;
+		driver_data->axis.horiz = horiz;
+		driver_data->axis.horiz_discrete = horiz_discrete;
 	}
-
-	xf86PostMotionEventM(dev, Relative, mask);
 }
 
 static void
@@ -834,59 +2721,163 @@ xf86libinput_handle_touch(InputInfoPtr pInfo,
 			  struct libinput_event_touch *event,
 			  enum libinput_event_type event_type)
 {
-	DeviceIntPtr dev = pInfo->dev;
 	struct xf86libinput *driver_data = pInfo->private;
-	int type;
-	int slot;
-	ValuatorMask *m = driver_data->valuators;
-	double val;
+	struct translate_post post;
+	double x = 0, y = 0;
+	int slot = libinput_event_touch_get_slot(event);
+
+	/* touch down and up are always delivered. Single-touch devices
+	   use slot -1, translate_touch() drops invalid slots */
+	if (event_type == LIBINPUT_EVENT_TOUCH_MOTION &&
+	    slot >= -1 && slot < TRANSLATE_MAX_TOUCHES &&
+	    xf86libinput_flood_drop_motion(driver_data,
+					   FLOOD_STREAM_TOUCH + max(slot, 0)))
+		return;
 
-	/* libinput doesn't give us hw touch ids which X expects, so
-	   emulate them here */
-	static unsigned int next_touchid;
-	static unsigned int touchids[TOUCH_MAX_SLOTS] = {0};
+	if (event_type == LIBINPUT_EVENT_TOUCH_DOWN ||
+	    event_type == LIBINPUT_EVENT_TOUCH_MOTION) {
+		x = libinput_event_touch_get_x_transformed(event, TOUCH_AXIS_MAX);
+		y = libinput_event_touch_get_y_transformed(event, TOUCH_AXIS_MAX);
+	}
 
-	slot = libinput_event_touch_get_slot(event);
+	if (translate_touch(&driver_data->core, event_type, slot, x, y,
+			    &post))
+		xf86libinput_post(pInfo, &post);
+}
 
-	switch (event_type) {
-		case LIBINPUT_EVENT_TOUCH_DOWN:
-			type = XI_TouchBegin;
-			touchids[slot] = next_touchid++;
-			break;
-		case LIBINPUT_EVENT_TOUCH_UP:
-			type = XI_TouchEnd;
-			break;
-		case LIBINPUT_EVENT_TOUCH_MOTION:
-			type = XI_TouchUpdate;
-			break;
-		default:
-			return;
-	};
+static inline void
+xf86libinput_record_event(InputInfoPtr pInfo,
+			  struct libinput_event *event,
+			  enum libinput_event_type type)
+{
+	uint32_t code = 0, value = 0;
 
-	valuator_mask_zero(m);
+	switch (type) {
+	case LIBINPUT_EVENT_KEYBOARD_KEY: {
+		struct libinput_event_keyboard *k = libinput_event_get_keyboard_event(event);
 
-	if (event_type != LIBINPUT_EVENT_TOUCH_UP) {
-		val = libinput_event_touch_get_x_transformed(event, TOUCH_AXIS_MAX);
-		valuator_mask_set_double(m, 0, val);
+		code = libinput_event_keyboard_get_key(k);
+		value = libinput_event_keyboard_get_key_state(k);
+		break;
+	}
+	case LIBINPUT_EVENT_POINTER_BUTTON: {
+		struct libinput_event_pointer *p = libinput_event_get_pointer_event(event);
 
-		val = libinput_event_touch_get_y_transformed(event, TOUCH_AXIS_MAX);
-		valuator_mask_set_double(m, 1, val);
+		code = libinput_event_pointer_get_button(p);
+		value = libinput_event_pointer_get_button_state(p);
+		break;
+	}
+	case LIBINPUT_EVENT_TOUCH_DOWN:
+	case LIBINPUT_EVENT_TOUCH_UP:
+	case LIBINPUT_EVENT_TOUCH_MOTION:
+	case LIBINPUT_EVENT_TOUCH_CANCEL:
+		code = libinput_event_touch_get_slot(libinput_event_get_touch_event(event));
+		break;
+	default:
+		break;
 	}
 
-	xf86PostTouchEvent(dev, touchids[slot], type, 0, m);
+	flight_recorder_event(pInfo->dev->id, type, code, value);
 }
 
 static void
+xf86libinput_stats_count_event(struct xf86libinput *driver_data,
+			       struct libinput_event *event,
+			       enum libinput_event_type type)
+{
+	enum stats_export_event_type t;
+	uint32_t time;
+	unsigned int latency, bucket;
+
+	switch (type) {
+	case LIBINPUT_EVENT_POINTER_MOTION:
+		t = STATS_EXPORT_EVENT_MOTION;
+		break;
+	case LIBINPUT_EVENT_POINTER_MOTION_ABSOLUTE:
+		t = STATS_EXPORT_EVENT_MOTION_ABSOLUTE;
+		break;
+	case LIBINPUT_EVENT_POINTER_BUTTON:
+		t = STATS_EXPORT_EVENT_BUTTON;
+		break;
+	case LIBINPUT_EVENT_POINTER_AXIS:
+		t = STATS_EXPORT_EVENT_AXIS;
+		break;
+	case LIBINPUT_EVENT_KEYBOARD_KEY:
+		t = STATS_EXPORT_EVENT_KEY;
+		break;
+	case LIBINPUT_EVENT_TOUCH_DOWN:
+	case LIBINPUT_EVENT_TOUCH_UP:
+	case LIBINPUT_EVENT_TOUCH_MOTION:
+	case LIBINPUT_EVENT_TOUCH_CANCEL:
+	case LIBINPUT_EVENT_TOUCH_FRAME:
+		t = STATS_EXPORT_EVENT_TOUCH;
+		break;
+	default:
+		driver_data->export.events[STATS_EXPORT_EVENT_OTHER]++;
+		return;
+	}
+
+	driver_data->export.events[t]++;
+
+	switch (t) {
+	case STATS_EXPORT_EVENT_KEY:
+		time = libinput_event_keyboard_get_time(libinput_event_get_keyboard_event(event));
+		break;
+	case STATS_EXPORT_EVENT_TOUCH:
+		time = libinput_event_touch_get_time(libinput_event_get_touch_event(event));
+		break;
+	default:
+		time = libinput_event_pointer_get_time(libinput_event_get_pointer_event(event));
+		break;
+	}
+
+	/* both are CLOCK_MONOTONIC in ms, wrapping at 32 bits */
+	latency = driver_context.drain_time_ms - time;
+	if (latency > (1U << 31))
+		latency = 0;
+	bucket = latency ? 32 - __builtin_clz(latency) : 0;
+	driver_data->export.latency[min(bucket, STATS_EXPORT_LATENCY_BUCKETS - 1)]++;
+}
+
+/* Returns the device the event was handled for, or NULL if it was
+   ignored */
+static InputInfoPtr
 xf86libinput_handle_event(struct libinput_event *event)
 {
 	struct libinput_device *device;
+	struct xf86libinput *driver_data;
 	InputInfoPtr pInfo;
 
 	device = libinput_event_get_device(event);
 	pInfo = libinput_device_get_user_data(device);
 
 	if (!pInfo || !pInfo->dev->public.on)
-		return;
+		return NULL;
+
+	driver_data = pInfo->private;
+
+	xf86libinput_record_event(pInfo, event, libinput_event_get_type(event));
+
+	if (driver_context.flood_devices > 0)
+		driver_data->flood.count++;
+
+	if (driver_context.stats_export)
+		xf86libinput_stats_count_event(driver_data, event,
+					       libinput_event_get_type(event));
+
+	/* new input from the device stops coasting. The device's kinetic
+	   state is only looked at while a device is coasting */
+	if (driver_context.kinetic_devices > 0)
+		xf86libinput_kinetic_cancel(driver_data);
+
+	/* keep the order of key events relative to other events from the
+	   same device */
+	if (libinput_event_get_type(event) != LIBINPUT_EVENT_KEYBOARD_KEY &&
+	    driver_data->burst.nkeys > 0)
+		xf86libinput_flush_keys(pInfo);
+	if (libinput_event_get_type(event) != LIBINPUT_EVENT_POINTER_AXIS &&
+	    driver_data->axis.pending)
+		xf86libinput_flush_axis(pInfo);
 
 	switch (libinput_event_get_type(event)) {
 		case LIBINPUT_EVENT_NONE:
@@ -925,30 +2916,163 @@ xf86libinput_handle_event(struct libinput_event *event)
 						  libinput_event_get_type(event));
 			break;
 	}
+
+	return pInfo;
+}
+
+/*
+   The watchdog times the stages of a read_input call: libinput_dispatch,
+   the events (fetching, translating and posting each) and the flush at
+   the end of the drain. Each event is timed from the end of the previous
+   one, so this is one clock read per event plus three per call.
+ */
+struct watchdog {
+	uint64_t start;
+	uint64_t dispatched;
+	uint64_t last; /* end of the last event */
+	uint64_t slowest; /* duration of the slowest event */
+	InputInfoPtr slowest_device; /* NULL if the event was ignored */
+	enum libinput_event_type slowest_type;
+};
+
+static inline void
+xf86libinput_watchdog_event(struct watchdog *wd,
+			    InputInfoPtr pInfo,
+			    struct libinput_event *event)
+{
+	uint64_t now = xf86libinput_now_us();
+
+	if (now - wd->last > wd->slowest) {
+		wd->slowest = now - wd->last;
+		wd->slowest_device = pInfo;
+		wd->slowest_type = libinput_event_get_type(event);
+	}
+	wd->last = now;
+}
+
+/* The warning is logged against the device of the slowest event, pInfo
+   only owns the fd shared by all devices */
+static void
+xf86libinput_watchdog_check(InputInfoPtr pInfo,
+			    struct watchdog *wd,
+			    unsigned int nevents)
+{
+	static struct ratelimit rl = RATELIMIT_INIT(5000, 5);
+	uint64_t end = xf86libinput_now_us();
+	uint64_t dispatch, events, flush;
+	const char *stage;
+
+	if (end - wd->start < driver_context.watchdog_threshold)
+		return;
+
+	dispatch = wd->dispatched - wd->start;
+	events = wd->last - wd->dispatched;
+	flush = end - wd->last;
+
+	if (dispatch >= events && dispatch >= flush)
+		stage = "dispatch";
+	else if (events >= flush)
+		stage = "events";
+	else
+		stage = "flush";
+
+	if (wd->slowest_device)
+		pInfo = wd->slowest_device;
+
+	xf86libinput_log_ratelimit(pInfo, &rl, X_WARNING,
+				   "watchdog: stage=%s total=%lluus dispatch=%lluus "
+				   "events=%lluus flush=%lluus nevents=%u "
+				   "slowest_device=%d slowest_type=%u slowest=%lluus\n",
+				   stage,
+				   (unsigned long long)(end - wd->start),
+				   (unsigned long long)dispatch,
+				   (unsigned long long)events,
+				   (unsigned long long)flush,
+				   nevents,
+				   wd->slowest_device ? wd->slowest_device->dev->id : -1,
+				   wd->slowest_type,
+				   (unsigned long long)wd->slowest);
 }
 
 static void
 xf86libinput_read_input(InputInfoPtr pInfo)
 {
 	struct libinput *libinput = driver_context.libinput;
+	struct xf86libinput *driver_data;
 	int rc;
 	struct libinput_event *event;
+	uint64_t now = 0;
+	unsigned int nevents = 0;
+	struct watchdog wd = { .slowest_device = NULL };
+	BOOL watchdog = driver_context.watchdog_threshold > 0;
+
+	driver_context.drain.wakeups++;
+
+	if (watchdog)
+		wd.start = xf86libinput_now_us();
+
+	if (driver_context.stats_export)
+		driver_context.drain_time_ms = (watchdog ? wd.start : xf86libinput_now_us()) / 1000;
 
         rc = libinput_dispatch(libinput);
-	if (rc == -EAGAIN)
-		return;
+
+	if (watchdog) {
+		wd.dispatched = xf86libinput_now_us();
+		wd.last = wd.dispatched;
+	}
+
+	if (rc == -EAGAIN) {
+		driver_context.drain.eagain++;
+		goto out;
+	}
 
 	if (rc < 0) {
-		xf86IDrvMsg(pInfo, X_ERROR,
-			    "Error reading events: %s\n",
-			    strerror(-rc));
-		return;
+		static struct ratelimit rl = RATELIMIT_INIT(5000, 5);
+
+		xf86libinput_log_ratelimit(pInfo, &rl, X_ERROR,
+					   "Error reading events: %s\n",
+					   strerror(-rc));
+		goto out;
 	}
 
 	while ((event = libinput_get_event(libinput))) {
-		xf86libinput_handle_event(event);
+		InputInfoPtr info = xf86libinput_handle_event(event);
+
+		if (watchdog)
+			xf86libinput_watchdog_event(&wd, info, event);
 		libinput_event_destroy(event);
+		nevents++;
+	}
+
+	driver_context.drain.histogram[drain_bucket(nevents)]++;
+
+	if (driver_context.stats_export)
+		xf86libinput_stats_export_publish();
+
+	if (driver_context.flood_devices > 0)
+		now = xf86libinput_now_us();
+
+	xorg_list_for_each_entry(driver_data, &driver_context.devices, node) {
+		InputInfoPtr info;
+
+		if (!driver_data->device)
+			continue;
+
+		info = libinput_device_get_user_data(driver_data->device);
+		if (!info)
+			continue;
+
+		if (driver_data->burst.nkeys > 0)
+			xf86libinput_flush_keys(info);
+		if (driver_data->axis.pending)
+			xf86libinput_flush_axis(info);
+		if (driver_data->flood.threshold > 0)
+			xf86libinput_flood_update(info, now);
 	}
+
+out:
+	if (watchdog)
+		xf86libinput_watchdog_check(pInfo, &wd, nevents);
 }
 
 static int
@@ -993,6 +3117,8 @@ xf86libinput_log_handler(struct libinput *libinput,
 	MessageType type;
 	int verbosity;
 
+	flight_recorder_log(priority, format, args);
+
 	switch(priority) {
 	case LIBINPUT_LOG_PRIORITY_DEBUG:
 		type = X_DEBUG;
@@ -1010,6 +3136,11 @@ xf86libinput_log_handler(struct libinput *libinput,
 		return;
 	}
 
+	/* if the priority was raised for debugging, make sure the
+	   messages end up in the log */
+	if (driver_context.log_priority_override)
+		verbosity = -1;
+
 	/* log messages in libinput are per-context, not per device, so we
 	   can't use xf86IDrvMsg here, and the server has no xf86VMsg or
 	   similar */
@@ -1169,13 +3300,7 @@ xf86libinput_parse_calibration_option(InputInfoPtr pInfo,
 	if ((str = xf86CheckStrOption(pInfo->options,
 				      "CalibrationMatrix",
 				      NULL))) {
-		int num_calibration = sscanf(str, "%f %f %f %f %f %f %f %f %f ",
-					     &matrix[0], &matrix[1],
-					     &matrix[2], &matrix[3],
-					     &matrix[4], &matrix[5],
-					     &matrix[6], &matrix[7],
-					     &matrix[8]);
-		if (num_calibration != 9) {
+		if (!translate_parse_matrix(str, matrix)) {
 			xf86IDrvMsg(pInfo, X_ERROR,
 				    "Invalid matrix: %s, using default\n",  str);
 		} else if (libinput_device_config_calibration_set_matrix(device,
@@ -1189,6 +3314,39 @@ xf86libinput_parse_calibration_option(InputInfoPtr pInfo,
 	}
 }
 
+static inline void
+xf86libinput_parse_output_area_option(InputInfoPtr pInfo,
+				      struct libinput_device *device,
+				      struct xf86libinput *driver_data)
+{
+	char *str;
+	unsigned int width, height;
+	int x, y;
+
+	memset(&driver_data->options.output_area, 0,
+	       sizeof(driver_data->options.output_area));
+
+	if (!libinput_device_config_calibration_has_matrix(device))
+		return;
+
+	str = xf86CheckStrOption(pInfo->options, "OutputArea", NULL);
+	if (!str)
+		return;
+
+	if (!translate_parse_output_area(str, &x, &y, &width, &height)) {
+		xf86IDrvMsg(pInfo, X_ERROR,
+			    "Invalid OutputArea: %s, using full desktop\n", str);
+	} else {
+		driver_data->options.output_area.x = x;
+		driver_data->options.output_area.y = y;
+		driver_data->options.output_area.width = width;
+		driver_data->options.output_area.height = height;
+		driver_data->has_output_area = TRUE;
+	}
+
+	free(str);
+}
+
 static inline BOOL
 xf86libinput_parse_lefthanded_option(InputInfoPtr pInfo,
 				     struct libinput_device *device)
@@ -1335,32 +3493,17 @@ xf86libinput_parse_buttonmap_option(InputInfoPtr pInfo,
 				    unsigned char *btnmap,
 				    size_t size)
 {
-	const int MAXBUTTONS = 32;
-	char *mapping, *map, *s = NULL;
-	int idx = 1;
+	char *mapping;
 
-	init_button_map(btnmap, size);
+	translate_init_button_map(btnmap, size);
 
 	mapping = xf86SetStrOption(pInfo->options, "ButtonMapping", NULL);
 	if (!mapping)
 		return;
 
-	map = mapping;
-	do
-	{
-		unsigned long int btn = strtoul(map, &s, 10);
-
-		if (s == map || btn > MAXBUTTONS)
-		{
-			xf86IDrvMsg(pInfo, X_ERROR,
-				    "... Invalid button mapping. Using defaults\n");
-			init_button_map(btnmap, size);
-			break;
-		}
-
-		btnmap[idx++] = btn;
-		map = s;
-	} while (s && *s != '\0' && idx < MAXBUTTONS);
+	if (!translate_parse_button_map(mapping, btnmap, size))
+		xf86IDrvMsg(pInfo, X_ERROR,
+			    "... Invalid button mapping. Using defaults\n");
 
 	free(mapping);
 }
@@ -1371,6 +3514,7 @@ xf86libinput_parse_options(InputInfoPtr pInfo,
 			   struct libinput_device *device)
 {
 	struct options *options = &driver_data->options;
+	int scroll_distance;
 
 	/* libinput options */
 	options->tapping = xf86libinput_parse_tap_option(pInfo, device);
@@ -1384,11 +3528,74 @@ xf86libinput_parse_options(InputInfoPtr pInfo,
 	options->click_method = xf86libinput_parse_clickmethod_option(pInfo, device);
 	options->middle_emulation = xf86libinput_parse_middleemulation_option(pInfo, device);
 	xf86libinput_parse_calibration_option(pInfo, device, driver_data->options.matrix);
+	xf86libinput_parse_output_area_option(pInfo, device, driver_data);
 
 	/* non-libinput options */
 	xf86libinput_parse_buttonmap_option(pInfo,
 					    options->btnmap,
 					    sizeof(options->btnmap));
+
+	if (libinput_device_has_capability(device, LIBINPUT_DEVICE_CAP_KEYBOARD) &&
+	    xf86SetBoolOption(pInfo->options, "KeyBurstMode", FALSE))
+		driver_data->burst.keys = xnfcalloc(KEY_BURST_SIZE,
+						    sizeof(*driver_data->burst.keys));
+
+	options->compact_properties = xf86SetBoolOption(pInfo->options,
+							"CompactProperties",
+							FALSE);
+
+	scroll_distance = xf86SetIntOption(pInfo->options, "ScrollDistance", 0);
+	if (scroll_distance > 0) {
+		scroll_distance = min(scroll_distance, SCROLL_DISTANCE_MAX);
+		driver_data->core.scroll.vdist = scroll_distance;
+		driver_data->core.scroll.hdist = scroll_distance;
+	} else {
+		driver_data->scroll_auto_vert = TRUE;
+		driver_data->scroll_auto_horiz = TRUE;
+	}
+
+	driver_data->kinetic.enabled = xf86SetBoolOption(pInfo->options,
+							 "KineticScrolling",
+							 FALSE);
+	driver_data->kinetic.time_constant = xf86SetIntOption(pInfo->options,
+							      "KineticScrollTimeConstant",
+							      325);
+	driver_data->kinetic.time_constant = max(1, min(KINETIC_MAX_TIME_CONSTANT,
+							(int)driver_data->kinetic.time_constant));
+	driver_data->kinetic.interval = xf86SetIntOption(pInfo->options,
+							 "KineticScrollInterval",
+							 16);
+	driver_data->kinetic.interval = max(KINETIC_MIN_INTERVAL,
+					    min(KINETIC_MAX_INTERVAL,
+						(int)driver_data->kinetic.interval));
+
+	driver_data->flood.threshold = max(0, xf86SetIntOption(pInfo->options,
+								"FloodThreshold",
+								0));
+	if (driver_data->flood.threshold > 0)
+		driver_context.flood_devices++;
+}
+
+static void
+xf86libinput_context_unref(void)
+{
+	driver_context.libinput = libinput_unref(driver_context.libinput);
+	if (driver_context.libinput != NULL)
+		return;
+
+	if (driver_context.led_timer) {
+		TimerFree(driver_context.led_timer);
+		driver_context.led_timer = NULL;
+	}
+	if (driver_context.ratelimit_timer) {
+		TimerFree(driver_context.ratelimit_timer);
+		driver_context.ratelimit_timer = NULL;
+	}
+	free(driver_context.flight_recorder_file);
+	driver_context.flight_recorder_file = NULL;
+	driver_context.log_priority = 0;
+	driver_context.watchdog_threshold = 0;
+	xf86libinput_stats_export_close();
 }
 
 static int
@@ -1407,20 +3614,18 @@ xf86libinput_pre_init(InputDriverPtr drv,
 	pInfo->control_proc = NULL;
 	pInfo->switch_mode = NULL;
 
-	driver_data = calloc(1, sizeof(*driver_data));
-	if (!driver_data)
+	if (posix_memalign((void**)&driver_data, CACHELINE_SIZE,
+			   sizeof(*driver_data)) != 0) {
+		driver_data = NULL;
 		goto fail;
+	}
+	memset(driver_data, 0, sizeof(*driver_data));
 
 	driver_data->valuators = valuator_mask_new(2);
 	if (!driver_data->valuators)
 		goto fail;
 
-	driver_data->valuators_unaccelerated = valuator_mask_new(2);
-	if (!driver_data->valuators_unaccelerated)
-		goto fail;
-
-	driver_data->scroll.vdist = 15;
-	driver_data->scroll.hdist = 15;
+	translate_device_init(&driver_data->core, SCROLL_DISTANCE_DEFAULT);
 
 	path = xf86SetStrOption(pInfo->options, "Device", NULL);
 	if (!path)
@@ -1430,10 +3635,8 @@ xf86libinput_pre_init(InputDriverPtr drv,
 		driver_context.libinput = libinput_path_create_context(&interface, &driver_context);
 		libinput_log_set_handler(driver_context.libinput,
 					 xf86libinput_log_handler);
-		/* we want all msgs, let the server filter */
-		libinput_log_set_priority(driver_context.libinput,
-					  LIBINPUT_LOG_PRIORITY_DEBUG);
 		xorg_list_init(&driver_context.server_fds);
+		xorg_list_init(&driver_context.devices);
 	} else {
 		libinput_ref(driver_context.libinput);
 	}
@@ -1445,6 +3648,29 @@ xf86libinput_pre_init(InputDriverPtr drv,
 		goto fail;
 	}
 
+	/* the verbosity may have changed since the last device was added */
+	xf86libinput_update_log_priority();
+
+	if (!driver_context.flight_recorder_file)
+		driver_context.flight_recorder_file = xf86CheckStrOption(pInfo->options,
+									 "FlightRecorderFile",
+									 NULL);
+
+	if (driver_context.watchdog_threshold == 0)
+		driver_context.watchdog_threshold = max(0, xf86SetIntOption(pInfo->options,
+									    "WatchdogThreshold",
+									    0));
+
+	if (!driver_context.stats_export) {
+		char *dir = xf86CheckStrOption(pInfo->options,
+					       "StatisticsDirectory",
+					       NULL);
+		if (dir) {
+			xf86libinput_stats_export_open(pInfo, dir);
+			free(dir);
+		}
+	}
+
 	if (use_server_fd(pInfo))
 		fd_push(&driver_context, pInfo->fd, path);
 
@@ -1465,6 +3691,10 @@ xf86libinput_pre_init(InputDriverPtr drv,
 	pInfo->private = driver_data;
 	driver_data->path = path;
 	driver_data->device = device;
+	driver_data->leds.applied = -1;
+	driver_data->export.slot = -1;
+	driver_data->pInfo = pInfo;
+	xorg_list_add(&driver_data->node, &driver_context.devices);
 
 	/* Disable acceleration in the server, libinput does it for us */
 	pInfo->options = xf86ReplaceIntOption(pInfo->options, "AccelerationProfile", -1);
@@ -1488,10 +3718,12 @@ xf86libinput_pre_init(InputDriverPtr drv,
 fail:
 	if (use_server_fd(pInfo) && driver_context.libinput != NULL)
 		fd_pop(&driver_context, pInfo->fd);
-	if (driver_data->valuators)
-		valuator_mask_free(&driver_data->valuators);
-	if (driver_data->valuators_unaccelerated)
-		valuator_mask_free(&driver_data->valuators_unaccelerated);
+	if (libinput)
+		xf86libinput_context_unref();
+	if (driver_data) {
+		if (driver_data->valuators)
+			valuator_mask_free(&driver_data->valuators);
+	}
 	free(path);
 	free(driver_data);
 	return BadValue;
@@ -1504,8 +3736,19 @@ xf86libinput_uninit(InputDriverPtr drv,
 {
 	struct xf86libinput *driver_data = pInfo->private;
 	if (driver_data) {
-		driver_context.libinput = libinput_unref(driver_context.libinput);
+		xf86libinput_ratelimit_flush_device(pInfo);
+		xorg_list_del(&driver_data->node);
+		/* still holds the ref from PreInit if DEVICE_INIT never
+		   happened */
+		if (driver_data->device)
+			libinput_device_unref(driver_data->device);
+		xf86libinput_context_unref();
 		valuator_mask_free(&driver_data->valuators);
+		if (driver_data->flood.threshold > 0)
+			driver_context.flood_devices--;
+		if (driver_data->kinetic.timer)
+			TimerFree(driver_data->kinetic.timer);
+		free(driver_data->burst.keys);
 		free(driver_data->path);
 		free(driver_data);
 		pInfo->private = NULL;
@@ -1560,6 +3803,7 @@ static Atom prop_tap_drag_lock;
 static Atom prop_tap_drag_lock_default;
 static Atom prop_calibration;
 static Atom prop_calibration_default;
+static Atom prop_output_area;
 static Atom prop_accel;
 static Atom prop_accel_default;
 static Atom prop_natural_scroll;
@@ -1579,12 +3823,61 @@ static Atom prop_click_method_enabled;
 static Atom prop_click_method_default;
 static Atom prop_middle_emulation;
 static Atom prop_middle_emulation_default;
+static Atom prop_log_priority;
+static Atom prop_flight_recorder_dump;
+static Atom prop_statistics;
+static Atom prop_flood;
+static Atom prop_drain_statistics;
+static Atom prop_config_batch;
+static Atom prop_defaults;
+static Atom prop_summary;
+static Atom prop_kinetic;
+static Atom prop_scroll_distance;
+
+/* TRUE while the driver updates one of its properties itself */
+static BOOL prop_internal_update;
+/* TRUE while the settings of a batch are set, the config is applied
+   once at the end */
+static BOOL prop_batch_update;
 
 /* general properties */
 static Atom prop_float;
 static Atom prop_device;
 static Atom prop_product_id;
 
+/*
+   Registry of the properties we handle, filled in once per server
+   generation by LibinputInitAtoms() and looked up by LibinputSetProperty.
+   Atoms are small sequential numbers, so the low bits are used as hash
+   with linear probing. The atoms are shared by all devices, each
+   property has a bit in the device's props bitmap that is set when the
+   property is created on that device.
+ */
+#define PROP_REGISTRY_SIZE 128 /* power of 2, at least twice PROP_MAX */
+#define PROP_MAX 64 /* bits in xf86libinput.props */
+
+typedef int (*prop_setter)(DeviceIntPtr dev, Atom atom,
+			   XIPropertyValuePtr val, BOOL checkonly);
+
+static struct prop_entry {
+	Atom atom;
+	prop_setter set; /* NULL for read-only properties */
+	uint32_t config; /* config_bits to apply after a change */
+	unsigned int bit; /* in xf86libinput.props */
+} prop_registry[PROP_REGISTRY_SIZE];
+
+static inline struct prop_entry *
+LibinputFindPropertySlot(Atom atom)
+{
+	unsigned int idx = atom & (PROP_REGISTRY_SIZE - 1);
+
+	while (prop_registry[idx].atom != None &&
+	       prop_registry[idx].atom != atom)
+		idx = (idx + 1) & (PROP_REGISTRY_SIZE - 1);
+
+	return &prop_registry[idx];
+}
+
 static inline BOOL
 xf86libinput_check_device (DeviceIntPtr dev,
 			   Atom atom)
@@ -1668,36 +3961,73 @@ LibinputSetPropertyTapDragLock(DeviceIntPtr dev,
 }
 
 static inline int
-LibinputSetPropertyCalibration(DeviceIntPtr dev,
-                               Atom atom,
-                               XIPropertyValuePtr val,
-			       BOOL checkonly)
+LibinputSetPropertyCalibration(DeviceIntPtr dev,
+                               Atom atom,
+                               XIPropertyValuePtr val,
+			       BOOL checkonly)
+{
+	InputInfoPtr pInfo = dev->public.devicePrivate;
+	struct xf86libinput *driver_data = pInfo->private;
+	struct libinput_device *device = driver_data->device;
+	float* data;
+
+	if (val->format != 32 || val->size != 9 || val->type != prop_float)
+		return BadMatch;
+
+	data = (float*)val->data;
+
+	if (checkonly) {
+		if (data[6] != 0 ||
+		    data[7] != 0 ||
+		    data[8] != 1)
+			return BadValue;
+
+		if (!xf86libinput_check_device (dev, atom))
+			return BadMatch;
+
+		if (!libinput_device_config_calibration_has_matrix(device))
+			return BadMatch;
+	} else {
+		memcpy(driver_data->options.matrix,
+		       data,
+		       sizeof(driver_data->options.matrix));
+	}
+
+	return Success;
+}
+
+static inline int
+LibinputSetPropertyOutputArea(DeviceIntPtr dev,
+			      Atom atom,
+			      XIPropertyValuePtr val,
+			      BOOL checkonly)
 {
 	InputInfoPtr pInfo = dev->public.devicePrivate;
 	struct xf86libinput *driver_data = pInfo->private;
 	struct libinput_device *device = driver_data->device;
-	float* data;
+	CARD32* data;
 
-	if (val->format != 32 || val->size != 9 || val->type != prop_float)
+	if (val->format != 32 || val->size != 4 || val->type != XA_CARDINAL)
 		return BadMatch;
 
-	data = (float*)val->data;
+	data = (CARD32*)val->data;
 
 	if (checkonly) {
-		if (data[6] != 0 ||
-		    data[7] != 0 ||
-		    data[8] != 1)
+		/* width and height must both be zero or both be set */
+		if ((data[2] == 0) != (data[3] == 0))
 			return BadValue;
 
-		if (!xf86libinput_check_device (dev, atom))
+		if (!xf86libinput_check_device(dev, atom))
 			return BadMatch;
 
 		if (!libinput_device_config_calibration_has_matrix(device))
 			return BadMatch;
 	} else {
-		memcpy(driver_data->options.matrix,
-		       data,
-		       sizeof(driver_data->options.matrix));
+		driver_data->options.output_area.x = (INT32)data[0];
+		driver_data->options.output_area.y = (INT32)data[1];
+		driver_data->options.output_area.width = data[2];
+		driver_data->options.output_area.height = data[3];
+		driver_data->has_output_area = (data[2] != 0);
 	}
 
 	return Success;
@@ -1890,181 +4220,813 @@ LibinputSetPropertyScrollButton(DeviceIntPtr dev,
 {
 	InputInfoPtr pInfo = dev->public.devicePrivate;
 	struct xf86libinput *driver_data = pInfo->private;
-	struct libinput_device *device = driver_data->device;
-	CARD32* data;
+	struct libinput_device *device = driver_data->device;
+	CARD32* data;
+
+	if (val->format != 32 || val->size != 1 || val->type != XA_CARDINAL)
+		return BadMatch;
+
+	data = (CARD32*)val->data;
+
+	if (checkonly) {
+		uint32_t button = *data;
+		uint32_t supported;
+
+		if (!xf86libinput_check_device (dev, atom))
+			return BadMatch;
+
+		supported = libinput_device_pointer_has_button(device,
+							       btn_xorg2linux(button));
+		if (button && !supported)
+			return BadValue;
+	} else {
+		driver_data->options.scroll_button = *data;
+	}
+
+	return Success;
+}
+
+static inline int
+LibinputSetPropertyClickMethod(DeviceIntPtr dev,
+			       Atom atom,
+			       XIPropertyValuePtr val,
+			       BOOL checkonly)
+{
+	InputInfoPtr pInfo = dev->public.devicePrivate;
+	struct xf86libinput *driver_data = pInfo->private;
+	struct libinput_device *device = driver_data->device;
+	BOOL* data;
+	uint32_t modes = 0;
+
+	if (val->format != 8 || val->size != 2 || val->type != XA_INTEGER)
+		return BadMatch;
+
+	data = (BOOL*)val->data;
+
+	if (data[0])
+		modes |= LIBINPUT_CONFIG_CLICK_METHOD_BUTTON_AREAS;
+	if (data[1])
+		modes |= LIBINPUT_CONFIG_CLICK_METHOD_CLICKFINGER;
+
+	if (checkonly) {
+		uint32_t supported;
+
+		if (__builtin_popcount(modes) > 1)
+			return BadValue;
+
+		if (!xf86libinput_check_device(dev, atom))
+			return BadMatch;
+
+		supported = libinput_device_config_click_get_methods(device);
+		if (modes && (modes & supported) == 0)
+			return BadValue;
+	} else {
+		driver_data->options.click_method = modes;
+	}
+
+	return Success;
+}
+
+static inline int
+LibinputSetPropertyMiddleEmulation(DeviceIntPtr dev,
+				   Atom atom,
+				   XIPropertyValuePtr val,
+				   BOOL checkonly)
+{
+	InputInfoPtr pInfo = dev->public.devicePrivate;
+	struct xf86libinput *driver_data = pInfo->private;
+	struct libinput_device *device = driver_data->device;
+	BOOL* data;
+
+	if (val->format != 8 || val->size != 1 || val->type != XA_INTEGER)
+		return BadMatch;
+
+	data = (BOOL*)val->data;
+	if (checkonly) {
+		if (*data != 0 && *data != 1)
+			return BadValue;
+
+		if (!xf86libinput_check_device(dev, atom))
+			return BadMatch;
+
+		if (!libinput_device_config_middle_emulation_is_available(device))
+			return BadMatch;
+	} else {
+		driver_data->options.middle_emulation = *data;
+	}
+
+	return Success;
+}
+
+/* The log priority is shared by all devices, update the property on
+   the other devices when it is set on one of them */
+static void
+LibinputSyncLogPriorityProperty(DeviceIntPtr dev)
+{
+	struct xf86libinput *driver_data;
+	const struct prop_entry *entry;
+	CARD32 priority = driver_context.log_priority_override;
+
+	entry = LibinputFindPropertySlot(prop_log_priority);
+
+	prop_internal_update = TRUE;
+	xorg_list_for_each_entry(driver_data, &driver_context.devices, node) {
+		DeviceIntPtr other = driver_data->pInfo->dev;
+
+		if (other == dev ||
+		    (driver_data->props & (1ULL << entry->bit)) == 0)
+			continue;
+
+		XIChangeDeviceProperty(other, prop_log_priority,
+				       XA_CARDINAL, 32,
+				       PropModeReplace, 1, &priority,
+				       TRUE);
+	}
+	prop_internal_update = FALSE;
+}
+
+static inline int
+LibinputSetPropertyLogPriority(DeviceIntPtr dev,
+			       Atom atom,
+			       XIPropertyValuePtr val,
+			       BOOL checkonly)
+{
+	CARD32* data;
+
+	if (val->format != 32 || val->size != 1 || val->type != XA_CARDINAL)
+		return BadMatch;
+
+	data = (CARD32*)val->data;
+
+	if (checkonly) {
+		switch (*data) {
+		case 0:
+		case LIBINPUT_LOG_PRIORITY_DEBUG:
+		case LIBINPUT_LOG_PRIORITY_INFO:
+		case LIBINPUT_LOG_PRIORITY_ERROR:
+			break;
+		default:
+			return BadValue;
+		}
+	} else if (!prop_internal_update) {
+		driver_context.log_priority_override = *data;
+		xf86libinput_update_log_priority();
+		LibinputSyncLogPriorityProperty(dev);
+	}
+
+	return Success;
+}
+
+static inline int
+LibinputSetPropertyKineticScrolling(DeviceIntPtr dev,
+				    Atom atom,
+				    XIPropertyValuePtr val,
+				    BOOL checkonly)
+{
+	InputInfoPtr pInfo = dev->public.devicePrivate;
+	struct xf86libinput *driver_data = pInfo->private;
+	CARD32* data;
+
+	if (val->format != 32 || val->size != 3 || val->type != XA_CARDINAL)
+		return BadMatch;
+
+	data = (CARD32*)val->data;
+
+	if (checkonly) {
+		if (data[0] > 1 ||
+		    data[1] < 1 || data[1] > KINETIC_MAX_TIME_CONSTANT ||
+		    data[2] < KINETIC_MIN_INTERVAL || data[2] > KINETIC_MAX_INTERVAL)
+			return BadValue;
+	} else {
+		driver_data->kinetic.enabled = data[0];
+		driver_data->kinetic.time_constant = data[1];
+		driver_data->kinetic.interval = data[2];
+		if (!driver_data->kinetic.enabled) {
+			xf86libinput_kinetic_cancel(driver_data);
+			driver_data->kinetic.last_time = 0;
+		}
+	}
+
+	return Success;
+}
+
+static inline int
+LibinputSetPropertyScrollDistance(DeviceIntPtr dev,
+				  Atom atom,
+				  XIPropertyValuePtr val,
+				  BOOL checkonly)
+{
+	InputInfoPtr pInfo = dev->public.devicePrivate;
+	struct xf86libinput *driver_data = pInfo->private;
+	CARD32* data;
+
+	if (val->format != 32 || val->size != 2 || val->type != XA_CARDINAL)
+		return BadMatch;
+
+	data = (CARD32*)val->data;
+
+	/* refreshed on read, see LibinputGetProperty */
+	if (prop_internal_update)
+		return Success;
+
+	if (checkonly) {
+		if (data[0] < 1 || data[0] > SCROLL_DISTANCE_MAX ||
+		    data[1] < 1 || data[1] > SCROLL_DISTANCE_MAX)
+			return BadValue;
+	} else {
+		driver_data->scroll_auto_vert = FALSE;
+		driver_data->scroll_auto_horiz = FALSE;
+
+		input_lock();
+		xf86libinput_set_scroll_distance(pInfo, data[0], data[1]);
+		input_unlock();
+	}
+
+	return Success;
+}
+
+static inline int
+LibinputSetPropertyFlightRecorderDump(DeviceIntPtr dev,
+				      Atom atom,
+				      XIPropertyValuePtr val,
+				      BOOL checkonly)
+{
+	BOOL* data;
+
+	if (val->format != 8 || val->size != 1 || val->type != XA_INTEGER)
+		return BadMatch;
+
+	data = (BOOL*)val->data;
+
+	if (checkonly) {
+		if (*data != 0 && *data != 1)
+			return BadValue;
+	} else if (*data) {
+		flight_recorder_dump(dev->public.devicePrivate);
+	}
+
+	return Success;
+}
+
+/* The largest number of values of a single setting in a batch, the
+   calibration matrix */
+#define CONFIG_BATCH_MAX_VALUES 9
+
+union config_batch_values {
+	CARD32 c32[CONFIG_BATCH_MAX_VALUES];
+	unsigned char c8[CONFIG_BATCH_MAX_VALUES];
+};
+
+/* Parse the batch record at *pos into atom and item, converting the
+   values into the format of the device's property. Only writable
+   libinput properties of this device are accepted. On success, *pos is
+   moved to the next record */
+static int
+LibinputConfigBatchRecord(DeviceIntPtr dev,
+			  XIPropertyValuePtr val,
+			  long *pos,
+			  Atom *atom,
+			  XIPropertyValuePtr item,
+			  union config_batch_values *values)
+{
+	InputInfoPtr pInfo = dev->public.devicePrivate;
+	struct xf86libinput *driver_data = pInfo->private;
+	const CARD32 *data = (CARD32*)val->data;
+	const struct prop_entry *entry;
+	XIPropertyValuePtr current;
+	long i = *pos;
+	CARD32 count, j;
+
+	if (val->size - i < 2)
+		return BadValue;
+
+	*atom = data[i];
+	count = data[i + 1];
+	i += 2;
+
+	if (count == 0 || count > CONFIG_BATCH_MAX_VALUES ||
+	    count > val->size - i)
+		return BadValue;
+
+	entry = LibinputFindPropertySlot(*atom);
+	if (entry->atom == None || entry->set == NULL ||
+	    entry->atom == prop_config_batch ||
+	    (driver_data->props & (1ULL << entry->bit)) == 0)
+		return BadMatch;
+
+	if (XIGetDeviceProperty(dev, *atom, &current) != Success)
+		return BadMatch;
+
+	item->type = current->type;
+	item->format = current->format;
+	item->size = count;
+
+	switch (current->format) {
+	case 8:
+		for (j = 0; j < count; j++) {
+			if (data[i + j] > 0xff)
+				return BadValue;
+			values->c8[j] = data[i + j];
+		}
+		item->data = values->c8;
+		break;
+	case 32:
+		memcpy(values->c32, &data[i], count * sizeof(CARD32));
+		item->data = values->c32;
+		break;
+	default:
+		return BadMatch;
+	}
+
+	*pos = i + count;
+
+	return Success;
+}
+
+/*
+   A batch is a list of records { atom, count, value, value, ... }, all
+   32 bit. Each value is converted to the format of the device's current
+   property of that atom, floats are passed as their bit pattern.
+
+   Every record is validated by its property's setter before anything is
+   changed, in the checkonly pass and again at the start of the commit
+   pass, so an invalid record never leaves a partially applied batch.
+   Then each property is changed, which also notifies clients, and the
+   config is applied once.
+ */
+static int
+LibinputSetPropertyConfigBatch(DeviceIntPtr dev,
+			       Atom atom,
+			       XIPropertyValuePtr val,
+			       BOOL checkonly)
+{
+	InputInfoPtr pInfo = dev->public.devicePrivate;
+	struct xf86libinput *driver_data = pInfo->private;
+	union config_batch_values values;
+	XIPropertyValueRec item;
+	Atom item_atom;
+	long i;
+	int rc = Success;
+
+	if (val->format != 32 || val->type != XA_INTEGER)
+		return BadMatch;
+
+	/* reset after being read, see LibinputGetProperty */
+	if (prop_internal_update)
+		return Success;
+
+	for (i = 0; i < val->size; ) {
+		rc = LibinputConfigBatchRecord(dev, val, &i, &item_atom,
+					       &item, &values);
+		if (rc == Success)
+			rc = LibinputSetProperty(dev, item_atom, &item, TRUE);
+		if (rc != Success)
+			return rc;
+	}
+
+	if (checkonly)
+		return Success;
+
+	prop_batch_update = TRUE;
+	for (i = 0; i < val->size; ) {
+		LibinputConfigBatchRecord(dev, val, &i, &item_atom,
+					  &item, &values);
+		/* all records passed their setters, this only fails if the
+		   server runs out of memory. The properties changed so far
+		   are still applied below */
+		rc = XIChangeDeviceProperty(dev, item_atom,
+					    item.type, item.format,
+					    PropModeReplace,
+					    item.size, item.data,
+					    TRUE);
+		if (rc != Success)
+			break;
+	}
+	prop_batch_update = FALSE;
+
+	LibinputApplyConfigMask(dev, driver_data->config_dirty);
+	driver_data->config_dirty = 0;
+
+	return rc;
+}
+
+static int
+LibinputSetProperty(DeviceIntPtr dev, Atom atom, XIPropertyValuePtr val,
+                 BOOL checkonly)
+{
+	InputInfoPtr pInfo = dev->public.devicePrivate;
+	struct xf86libinput *driver_data = pInfo->private;
+	struct prop_entry *entry;
+	int rc;
 
-	if (val->format != 32 || val->size != 1 || val->type != XA_CARDINAL)
-		return BadMatch;
+	entry = LibinputFindPropertySlot(atom);
+	if (entry->atom == None)
+		return Success;
 
-	data = (CARD32*)val->data;
+	if ((driver_data->props & (1ULL << entry->bit)) == 0)
+		return BadMatch;
 
-	if (checkonly) {
-		uint32_t button = *data;
-		uint32_t supported;
+	if (!entry->set)
+		return prop_internal_update ? Success : BadAccess; /* read-only */
 
-		if (!xf86libinput_check_device (dev, atom))
-			return BadMatch;
+	rc = entry->set(dev, atom, val, checkonly);
 
-		supported = libinput_device_pointer_has_button(device,
-							       btn_xorg2linux(button));
-		if (button && !supported)
-			return BadValue;
-	} else {
-		driver_data->options.scroll_button = *data;
+	if (!checkonly && rc == Success) {
+		driver_data->config_dirty |= entry->config;
+		if (!prop_batch_update) {
+			LibinputApplyConfigMask(dev, driver_data->config_dirty);
+			driver_data->config_dirty = 0;
+		}
 	}
 
-	return Success;
+	return rc;
 }
 
-static inline int
-LibinputSetPropertyClickMethod(DeviceIntPtr dev,
-			       Atom atom,
-			       XIPropertyValuePtr val,
-			       BOOL checkonly)
+static void
+LibinputUpdateStatisticsProperty(DeviceIntPtr dev)
 {
 	InputInfoPtr pInfo = dev->public.devicePrivate;
 	struct xf86libinput *driver_data = pInfo->private;
-	struct libinput_device *device = driver_data->device;
-	BOOL* data;
-	uint32_t modes = 0;
+	CARD32 stats[5];
+
+	stats[0] = driver_data->core.suppressed_motion;
+	stats[1] = driver_context.log_suppressed;
+	stats[2] = driver_data->flood.dropped;
+	stats[3] = driver_data->axis.events;
+	stats[4] = driver_data->axis.posted;
+
+	prop_internal_update = TRUE;
+	XIChangeDeviceProperty(dev, prop_statistics, XA_CARDINAL, 32,
+			       PropModeReplace, ARRAY_SIZE(stats), stats,
+			       FALSE);
+	prop_internal_update = FALSE;
+}
 
-	if (val->format != 8 || val->size != 2 || val->type != XA_INTEGER)
-		return BadMatch;
+static void
+LibinputUpdateFloodProperty(DeviceIntPtr dev)
+{
+	InputInfoPtr pInfo = dev->public.devicePrivate;
+	struct xf86libinput *driver_data = pInfo->private;
+	CARD32 flood[3];
 
-	data = (BOOL*)val->data;
+	/* the atom is shared, but not all devices have the property */
+	if (driver_data->flood.threshold == 0)
+		return;
 
-	if (data[0])
-		modes |= LIBINPUT_CONFIG_CLICK_METHOD_BUTTON_AREAS;
-	if (data[1])
-		modes |= LIBINPUT_CONFIG_CLICK_METHOD_CLICKFINGER;
+	flood[0] = driver_data->flood.threshold;
+	flood[1] = driver_data->flood.rate;
+	flood[2] = driver_data->flood.throttled;
 
-	if (checkonly) {
-		uint32_t supported;
+	prop_internal_update = TRUE;
+	XIChangeDeviceProperty(dev, prop_flood, XA_CARDINAL, 32,
+			       PropModeReplace, ARRAY_SIZE(flood), flood,
+			       FALSE);
+	prop_internal_update = FALSE;
+}
 
-		if (__builtin_popcount(modes) > 1)
-			return BadValue;
+static void
+LibinputUpdateDrainStatisticsProperty(DeviceIntPtr dev)
+{
+	CARD32 stats[3 + DRAIN_HISTOGRAM_SIZE];
+	uint64_t now = xf86libinput_now_us();
+	size_t i;
+
+	if (driver_context.drain.last_time != 0 &&
+	    now > driver_context.drain.last_time)
+		driver_context.drain.rate = (driver_context.drain.wakeups -
+					     driver_context.drain.last_wakeups) * 1000000 /
+					    (now - driver_context.drain.last_time);
+	driver_context.drain.last_time = now;
+	driver_context.drain.last_wakeups = driver_context.drain.wakeups;
+
+	stats[0] = driver_context.drain.wakeups;
+	stats[1] = driver_context.drain.eagain;
+	stats[2] = driver_context.drain.rate;
+	for (i = 0; i < DRAIN_HISTOGRAM_SIZE; i++)
+		stats[3 + i] = driver_context.drain.histogram[i];
+
+	prop_internal_update = TRUE;
+	XIChangeDeviceProperty(dev, prop_drain_statistics, XA_CARDINAL, 32,
+			       PropModeReplace, ARRAY_SIZE(stats), stats,
+			       FALSE);
+	prop_internal_update = FALSE;
+}
 
-		if (!xf86libinput_check_device(dev, atom))
-			return BadMatch;
+/* Some read-only properties are only updated when a client reads them */
+#define SUMMARY_VERSION 2
+#define SUMMARY_SIZE 56
 
-		supported = libinput_device_config_click_get_methods(device);
-		if (modes && (modes & supported) == 0)
-			return BadValue;
+static inline CARD32
+float_bits(float f)
+{
+	CARD32 bits;
+
+	memcpy(&bits, &f, sizeof(bits));
+	return bits;
+}
+
+/* See LIBINPUT_PROP_SUMMARY for the layout */
+static void
+LibinputFillSummary(struct xf86libinput *driver_data,
+		    struct libinput_device *device,
+		    CARD32 summary[SUMMARY_SIZE])
+{
+	struct options *options = &driver_data->options;
+	CARD32 *v = summary;
+	uint32_t available = 0;
+	float matrix[9] = {0};
+	int i;
+
+	*v++ = SUMMARY_VERSION;
+	*v++ = SUMMARY_SIZE;
+
+	*v++ = (libinput_device_has_capability(device, LIBINPUT_DEVICE_CAP_KEYBOARD) << 0) |
+	       (libinput_device_has_capability(device, LIBINPUT_DEVICE_CAP_POINTER) << 1) |
+	       (libinput_device_has_capability(device, LIBINPUT_DEVICE_CAP_TOUCH) << 2);
+	*v++ = libinput_device_get_id_vendor(device);
+	*v++ = libinput_device_get_id_product(device);
+
+	if (libinput_device_config_send_events_get_modes(device) != LIBINPUT_CONFIG_SEND_EVENTS_ENABLED)
+		available |= CONFIG_SENDEVENTS;
+	if (libinput_device_config_scroll_has_natural_scroll(device))
+		available |= CONFIG_NATURAL_SCROLL;
+	if (libinput_device_config_accel_is_available(device))
+		available |= CONFIG_ACCEL;
+	if (libinput_device_config_tap_get_finger_count(device) > 0)
+		available |= CONFIG_TAP | CONFIG_TAP_DRAG_LOCK;
+	if (libinput_device_config_calibration_has_matrix(device))
+		available |= CONFIG_CALIBRATION;
+	if (libinput_device_config_left_handed_is_available(device))
+		available |= CONFIG_LEFT_HANDED;
+	if (libinput_device_config_scroll_get_methods(device) != LIBINPUT_CONFIG_SCROLL_NO_SCROLL)
+		available |= CONFIG_SCROLL_METHOD;
+	if (libinput_device_config_scroll_get_methods(device) & LIBINPUT_CONFIG_SCROLL_ON_BUTTON_DOWN)
+		available |= CONFIG_SCROLL_BUTTON;
+	if (libinput_device_config_click_get_methods(device) != LIBINPUT_CONFIG_CLICK_METHOD_NONE)
+		available |= CONFIG_CLICK_METHOD;
+	if (libinput_device_config_middle_emulation_is_available(device))
+		available |= CONFIG_MIDDLE_EMULATION;
+	*v++ = available;
+
+	/* same flags as the flight recorder */
+	*v++ = (!!options->tapping) |
+	       (!!options->tap_drag_lock) << 1 |
+	       (!!options->natural_scrolling) << 2 |
+	       (!!options->left_handed) << 3 |
+	       (!!options->middle_emulation) << 4;
+	*v++ = (!!libinput_device_config_tap_get_default_enabled(device)) |
+	       (!!libinput_device_config_tap_get_default_drag_lock_enabled(device)) << 1 |
+	       (!!libinput_device_config_scroll_get_default_natural_scroll_enabled(device)) << 2 |
+	       (!!libinput_device_config_left_handed_get_default(device)) << 3 |
+	       (!!libinput_device_config_middle_emulation_get_default_enabled(device)) << 4;
+
+	*v++ = options->sendevents;
+	*v++ = libinput_device_config_send_events_get_modes(device);
+	*v++ = libinput_device_config_send_events_get_default_mode(device);
+	*v++ = options->scroll_method;
+	*v++ = libinput_device_config_scroll_get_methods(device);
+	*v++ = libinput_device_config_scroll_get_default_method(device);
+	*v++ = options->click_method;
+	*v++ = libinput_device_config_click_get_methods(device);
+	*v++ = libinput_device_config_click_get_default_method(device);
+	*v++ = options->scroll_button;
+	*v++ = (available & CONFIG_SCROLL_BUTTON) ?
+		btn_linux2xorg(libinput_device_config_scroll_get_default_button(device)) : 0;
+
+	*v++ = float_bits(options->speed);
+	*v++ = float_bits((available & CONFIG_ACCEL) ?
+			  libinput_device_config_accel_get_default_speed(device) : 0);
+
+	for (i = 0; i < 9; i++)
+		*v++ = float_bits(options->matrix[i]);
+	if (available & CONFIG_CALIBRATION) {
+		libinput_device_config_calibration_get_default_matrix(device, matrix);
+		matrix[8] = 1;
+	}
+	for (i = 0; i < 9; i++)
+		*v++ = float_bits(matrix[i]);
+
+	*v++ = options->output_area.x;
+	*v++ = options->output_area.y;
+	*v++ = options->output_area.width;
+	*v++ = options->output_area.height;
+
+	/* buttons 1-32, four per value, lowest byte first */
+	for (i = 0; i < 8; i++)
+		*v++ = options->btnmap[i * 4 + 1] |
+		       options->btnmap[i * 4 + 2] << 8 |
+		       options->btnmap[i * 4 + 3] << 16 |
+		       (CARD32)options->btnmap[i * 4 + 4] << 24;
+
+	/* version 2 */
+	if (libinput_device_config_scroll_get_methods(device) &
+	    (LIBINPUT_CONFIG_SCROLL_2FG|LIBINPUT_CONFIG_SCROLL_EDGE)) {
+		*v++ = driver_data->kinetic.enabled;
+		*v++ = driver_data->kinetic.time_constant;
+		*v++ = driver_data->kinetic.interval;
 	} else {
-		driver_data->options.click_method = modes;
+		*v++ = 0;
+		*v++ = 0;
+		*v++ = 0;
 	}
 
-	return Success;
+	if (libinput_device_has_capability(device, LIBINPUT_DEVICE_CAP_POINTER)) {
+		*v++ = driver_data->core.scroll.vdist;
+		*v++ = driver_data->core.scroll.hdist;
+	} else {
+		*v++ = 0;
+		*v++ = 0;
+	}
+
+	BUG_WARN(v - summary != SUMMARY_SIZE);
 }
 
-static inline int
-LibinputSetPropertyMiddleEmulation(DeviceIntPtr dev,
-				   Atom atom,
-				   XIPropertyValuePtr val,
-				   BOOL checkonly)
+static void
+LibinputUpdateSummaryProperty(DeviceIntPtr dev)
 {
 	InputInfoPtr pInfo = dev->public.devicePrivate;
 	struct xf86libinput *driver_data = pInfo->private;
-	struct libinput_device *device = driver_data->device;
-	BOOL* data;
+	CARD32 summary[SUMMARY_SIZE];
 
-	if (val->format != 8 || val->size != 1 || val->type != XA_INTEGER)
-		return BadMatch;
+	/* keep the last values while the device is disabled */
+	if (driver_data->device == NULL)
+		return;
 
-	data = (BOOL*)val->data;
-	if (checkonly) {
-		if (*data != 0 && *data != 1)
-			return BadValue;
+	LibinputFillSummary(driver_data, driver_data->device, summary);
 
-		if (!xf86libinput_check_device(dev, atom))
-			return BadMatch;
+	prop_internal_update = TRUE;
+	XIChangeDeviceProperty(dev, prop_summary, XA_CARDINAL, 32,
+			       PropModeReplace, ARRAY_SIZE(summary), summary,
+			       FALSE);
+	prop_internal_update = FALSE;
+}
 
-		if (!libinput_device_config_middle_emulation_is_available(device))
-			return BadMatch;
-	} else {
-		driver_data->options.middle_emulation = *data;
+static void
+LibinputUpdateScrollDistanceProperty(DeviceIntPtr dev)
+{
+	InputInfoPtr pInfo = dev->public.devicePrivate;
+	struct xf86libinput *driver_data = pInfo->private;
+	CARD32 dist[2];
+
+	/* may have been derived from a wheel event since */
+	dist[0] = driver_data->core.scroll.vdist;
+	dist[1] = driver_data->core.scroll.hdist;
+
+	prop_internal_update = TRUE;
+	XIChangeDeviceProperty(dev, prop_scroll_distance, XA_CARDINAL, 32,
+			       PropModeReplace, ARRAY_SIZE(dist), dist,
+			       FALSE);
+	prop_internal_update = FALSE;
+}
+
+static int
+LibinputGetProperty(DeviceIntPtr dev, Atom atom)
+{
+	if (atom == prop_statistics)
+		LibinputUpdateStatisticsProperty(dev);
+	else if (atom == prop_flood)
+		LibinputUpdateFloodProperty(dev);
+	else if (atom == prop_drain_statistics)
+		LibinputUpdateDrainStatisticsProperty(dev);
+	else if (atom == prop_summary)
+		LibinputUpdateSummaryProperty(dev);
+	else if (atom == prop_scroll_distance)
+		LibinputUpdateScrollDistanceProperty(dev);
+	else if (atom == prop_config_batch) {
+		/* write-only, reading it gives an empty batch */
+		prop_internal_update = TRUE;
+		XIChangeDeviceProperty(dev, prop_config_batch, XA_INTEGER, 32,
+				       PropModeReplace, 0, NULL, FALSE);
+		prop_internal_update = FALSE;
 	}
 
 	return Success;
 }
 
-static int
-LibinputSetProperty(DeviceIntPtr dev, Atom atom, XIPropertyValuePtr val,
-                 BOOL checkonly)
+/* At most PROP_MAX entries */
+static const struct prop_description {
+	Atom *atom;
+	const char *name;
+	prop_setter set;
+	uint32_t config;
+} prop_descriptions[] = {
+	{ &prop_tap, LIBINPUT_PROP_TAP,
+	  LibinputSetPropertyTap, CONFIG_TAP },
+	{ &prop_tap_default, LIBINPUT_PROP_TAP_DEFAULT, NULL, 0 },
+	{ &prop_tap_drag_lock, LIBINPUT_PROP_TAP_DRAG_LOCK,
+	  LibinputSetPropertyTapDragLock, CONFIG_TAP_DRAG_LOCK },
+	{ &prop_tap_drag_lock_default, LIBINPUT_PROP_TAP_DRAG_LOCK_DEFAULT, NULL, 0 },
+	{ &prop_calibration, LIBINPUT_PROP_CALIBRATION,
+	  LibinputSetPropertyCalibration, CONFIG_CALIBRATION },
+	{ &prop_calibration_default, LIBINPUT_PROP_CALIBRATION_DEFAULT, NULL, 0 },
+	{ &prop_output_area, LIBINPUT_PROP_OUTPUT_AREA,
+	  LibinputSetPropertyOutputArea, CONFIG_CALIBRATION },
+	{ &prop_accel, LIBINPUT_PROP_ACCEL,
+	  LibinputSetPropertyAccel, CONFIG_ACCEL },
+	{ &prop_accel_default, LIBINPUT_PROP_ACCEL_DEFAULT, NULL, 0 },
+	{ &prop_natural_scroll, LIBINPUT_PROP_NATURAL_SCROLL,
+	  LibinputSetPropertyNaturalScroll, CONFIG_NATURAL_SCROLL },
+	{ &prop_natural_scroll_default, LIBINPUT_PROP_NATURAL_SCROLL_DEFAULT, NULL, 0 },
+	{ &prop_sendevents_available, LIBINPUT_PROP_SENDEVENTS_AVAILABLE, NULL, 0 },
+	{ &prop_sendevents_enabled, LIBINPUT_PROP_SENDEVENTS_ENABLED,
+	  LibinputSetPropertySendEvents, CONFIG_SENDEVENTS },
+	{ &prop_sendevents_default, LIBINPUT_PROP_SENDEVENTS_ENABLED_DEFAULT, NULL, 0 },
+	{ &prop_left_handed, LIBINPUT_PROP_LEFT_HANDED,
+	  LibinputSetPropertyLeftHanded, CONFIG_LEFT_HANDED },
+	{ &prop_left_handed_default, LIBINPUT_PROP_LEFT_HANDED_DEFAULT, NULL, 0 },
+	{ &prop_scroll_methods_available, LIBINPUT_PROP_SCROLL_METHODS_AVAILABLE, NULL, 0 },
+	{ &prop_scroll_method_enabled, LIBINPUT_PROP_SCROLL_METHOD_ENABLED,
+	  LibinputSetPropertyScrollMethods, CONFIG_SCROLL_METHOD },
+	{ &prop_scroll_method_default, LIBINPUT_PROP_SCROLL_METHOD_ENABLED_DEFAULT, NULL, 0 },
+	{ &prop_scroll_button, LIBINPUT_PROP_SCROLL_BUTTON,
+	  LibinputSetPropertyScrollButton, CONFIG_SCROLL_BUTTON },
+	{ &prop_scroll_button_default, LIBINPUT_PROP_SCROLL_BUTTON_DEFAULT, NULL, 0 },
+	{ &prop_click_methods_available, LIBINPUT_PROP_CLICK_METHODS_AVAILABLE, NULL, 0 },
+	{ &prop_click_method_enabled, LIBINPUT_PROP_CLICK_METHOD_ENABLED,
+	  LibinputSetPropertyClickMethod, CONFIG_CLICK_METHOD },
+	{ &prop_click_method_default, LIBINPUT_PROP_CLICK_METHOD_ENABLED_DEFAULT, NULL, 0 },
+	{ &prop_middle_emulation, LIBINPUT_PROP_MIDDLE_EMULATION_ENABLED,
+	  LibinputSetPropertyMiddleEmulation, CONFIG_MIDDLE_EMULATION },
+	{ &prop_middle_emulation_default, LIBINPUT_PROP_MIDDLE_EMULATION_ENABLED_DEFAULT, NULL, 0 },
+	{ &prop_log_priority, LIBINPUT_PROP_LOG_PRIORITY,
+	  LibinputSetPropertyLogPriority, 0 },
+	{ &prop_flight_recorder_dump, LIBINPUT_PROP_FLIGHT_RECORDER_DUMP,
+	  LibinputSetPropertyFlightRecorderDump, 0 },
+	{ &prop_statistics, LIBINPUT_PROP_STATISTICS, NULL, 0 },
+	{ &prop_flood, LIBINPUT_PROP_FLOOD, NULL, 0 },
+	{ &prop_drain_statistics, LIBINPUT_PROP_DRAIN_STATISTICS, NULL, 0 },
+	{ &prop_config_batch, LIBINPUT_PROP_CONFIG_BATCH,
+	  LibinputSetPropertyConfigBatch, 0 },
+	{ &prop_defaults, LIBINPUT_PROP_DEFAULTS, NULL, 0 },
+	{ &prop_summary, LIBINPUT_PROP_SUMMARY, NULL, 0 },
+	{ &prop_kinetic, LIBINPUT_PROP_KINETIC_SCROLLING,
+	  LibinputSetPropertyKineticScrolling, 0 },
+	{ &prop_scroll_distance, LIBINPUT_PROP_SCROLL_DISTANCE,
+	  LibinputSetPropertyScrollDistance, 0 },
+	{ &prop_device, XI_PROP_DEVICE_NODE, NULL, 0 },
+	{ &prop_product_id, XI_PROP_PRODUCT_ID, NULL, 0 },
+};
+
+/* Create our atoms and fill the registry, once per server generation */
+static void
+LibinputInitAtoms(void)
 {
-	int rc;
+	static unsigned long generation;
+	size_t i;
 
-	if (atom == prop_tap)
-		rc = LibinputSetPropertyTap(dev, atom, val, checkonly);
-	else if (atom == prop_tap_drag_lock)
-		rc = LibinputSetPropertyTapDragLock(dev, atom, val, checkonly);
-	else if (atom == prop_calibration)
-		rc = LibinputSetPropertyCalibration(dev, atom, val,
-						    checkonly);
-	else if (atom == prop_accel)
-		rc = LibinputSetPropertyAccel(dev, atom, val, checkonly);
-	else if (atom == prop_natural_scroll)
-		rc = LibinputSetPropertyNaturalScroll(dev, atom, val, checkonly);
-	else if (atom == prop_sendevents_available)
-		return BadAccess; /* read-only */
-	else if (atom == prop_sendevents_enabled)
-		rc = LibinputSetPropertySendEvents(dev, atom, val, checkonly);
-	else if (atom == prop_left_handed)
-		rc = LibinputSetPropertyLeftHanded(dev, atom, val, checkonly);
-	else if (atom == prop_scroll_methods_available)
-		return BadAccess; /* read-only */
-	else if (atom == prop_scroll_method_enabled)
-		rc = LibinputSetPropertyScrollMethods(dev, atom, val, checkonly);
-	else if (atom == prop_scroll_button)
-		rc = LibinputSetPropertyScrollButton(dev, atom, val, checkonly);
-	else if (atom == prop_click_methods_available)
-		return BadAccess; /* read-only */
-	else if (atom == prop_click_method_enabled)
-		rc = LibinputSetPropertyClickMethod(dev, atom, val, checkonly);
-	else if (atom == prop_middle_emulation)
-		rc = LibinputSetPropertyMiddleEmulation(dev, atom, val, checkonly);
-	else if (atom == prop_device || atom == prop_product_id ||
-		 atom == prop_tap_default ||
-		 atom == prop_tap_drag_lock_default ||
-		 atom == prop_calibration_default ||
-		 atom == prop_accel_default ||
-		 atom == prop_natural_scroll_default ||
-		 atom == prop_sendevents_default ||
-		 atom == prop_left_handed_default ||
-		 atom == prop_scroll_method_default ||
-		 atom == prop_scroll_button_default ||
-		 atom == prop_click_method_default ||
-		 atom == prop_middle_emulation_default)
-		return BadAccess; /* read-only */
-	else
-		return Success;
+	if (generation == serverGeneration)
+		return;
 
-	if (!checkonly && rc == Success)
-		LibinputApplyConfig(dev);
+	BUG_RETURN(ARRAY_SIZE(prop_descriptions) > PROP_MAX);
 
-	return rc;
+	generation = serverGeneration;
+	memset(prop_registry, 0, sizeof(prop_registry));
+
+	prop_float = XIGetKnownProperty("FLOAT");
+
+	for (i = 0; i < ARRAY_SIZE(prop_descriptions); i++) {
+		const struct prop_description *desc = &prop_descriptions[i];
+		struct prop_entry *entry;
+		Atom atom;
+
+		atom = MakeAtom(desc->name, strlen(desc->name), TRUE);
+		*desc->atom = atom;
+
+		entry = LibinputFindPropertySlot(atom);
+		entry->atom = atom;
+		entry->set = desc->set;
+		entry->config = desc->config;
+		entry->bit = i;
+	}
 }
 
-static Atom
+/* Returns TRUE if the property was created and marked as supported by
+   the device */
+static BOOL
 LibinputMakeProperty(DeviceIntPtr dev,
-		     const char *prop_name,
+		     Atom prop,
 		     Atom type,
 		     int format,
 		     int len,
 		     void *data)
 {
+	InputInfoPtr pInfo = dev->public.devicePrivate;
+	struct xf86libinput *driver_data = pInfo->private;
 	int rc;
-	Atom prop = MakeAtom(prop_name, strlen(prop_name), TRUE);
+
+	if (prop == None)
+		return FALSE;
 
 	rc = XIChangeDeviceProperty(dev, prop, type, format,
 				    PropModeReplace,
 				    len, data, FALSE);
 	if (rc != Success)
-		return None;
+		return FALSE;
 
 	XISetDevicePropertyDeletable(dev, prop, FALSE);
+	driver_data->props |= 1ULL << LibinputFindPropertySlot(prop)->bit;
 
-	return prop;
+	return TRUE;
 }
 
 static void
@@ -2077,20 +5039,18 @@ LibinputInitTapProperty(DeviceIntPtr dev,
 	if (libinput_device_config_tap_get_finger_count(device) == 0)
 		return;
 
-	prop_tap = LibinputMakeProperty(dev,
-					LIBINPUT_PROP_TAP,
-					XA_INTEGER,
-					8,
-					1,
-					&tap);
-	if (!prop_tap)
+	if (!LibinputMakeProperty(dev, prop_tap,
+				  XA_INTEGER, 8,
+				  1, &tap))
+		return;
+
+	if (driver_data->options.compact_properties)
 		return;
 
 	tap = libinput_device_config_tap_get_default_enabled(device);
-	prop_tap_default = LibinputMakeProperty(dev,
-						LIBINPUT_PROP_TAP_DEFAULT,
-						XA_INTEGER, 8,
-						1, &tap);
+	LibinputMakeProperty(dev, prop_tap_default,
+			     XA_INTEGER, 8,
+			     1, &tap);
 }
 
 static void
@@ -2103,18 +5063,18 @@ LibinputInitTapDragLockProperty(DeviceIntPtr dev,
 	if (libinput_device_config_tap_get_finger_count(device) == 0)
 		return;
 
-	prop_tap_drag_lock = LibinputMakeProperty(dev,
-						  LIBINPUT_PROP_TAP_DRAG_LOCK,
-						  XA_INTEGER, 8,
-						  1, &drag_lock);
-	if (!prop_tap_drag_lock)
+	if (!LibinputMakeProperty(dev, prop_tap_drag_lock,
+				  XA_INTEGER, 8,
+				  1, &drag_lock))
+		return;
+
+	if (driver_data->options.compact_properties)
 		return;
 
 	drag_lock = libinput_device_config_tap_get_default_enabled(device);
-	prop_tap_drag_lock_default = LibinputMakeProperty(dev,
-							  LIBINPUT_PROP_TAP_DRAG_LOCK_DEFAULT,
-							  XA_INTEGER, 8,
-							  1, &drag_lock);
+	LibinputMakeProperty(dev, prop_tap_drag_lock_default,
+			     XA_INTEGER, 8,
+			     1, &drag_lock);
 }
 
 static void
@@ -2128,27 +5088,44 @@ LibinputInitCalibrationProperty(DeviceIntPtr dev,
 		return;
 
 	/* We use a 9-element matrix just to be closer to the X server's
-	   transformation matrix which also has the full matrix */
+	   transformation matrix which also has the full matrix.
+	   The matrix applied to the device has the output area folded in,
+	   the property holds the calibration alone */
 
-	libinput_device_config_calibration_get_matrix(device, calibration);
-	calibration[6] = 0;
-	calibration[7] = 0;
-	calibration[8] = 1;
+	if (!LibinputMakeProperty(dev, prop_calibration,
+				  prop_float, 32,
+				  9, driver_data->options.matrix))
+		return;
 
-	prop_calibration = LibinputMakeProperty(dev,
-						LIBINPUT_PROP_CALIBRATION,
-						prop_float, 32,
-						9, calibration);
-	if (!prop_calibration)
+	if (driver_data->options.compact_properties)
 		return;
 
 	libinput_device_config_calibration_get_default_matrix(device,
 							      calibration);
 
-	prop_calibration_default = LibinputMakeProperty(dev,
-							LIBINPUT_PROP_CALIBRATION_DEFAULT,
-							prop_float, 32,
-							9, calibration);
+	LibinputMakeProperty(dev, prop_calibration_default,
+			     prop_float, 32,
+			     9, calibration);
+}
+
+static void
+LibinputInitOutputAreaProperty(DeviceIntPtr dev,
+			       struct xf86libinput *driver_data,
+			       struct libinput_device *device)
+{
+	CARD32 area[4];
+
+	if (!libinput_device_config_calibration_has_matrix(device))
+		return;
+
+	area[0] = driver_data->options.output_area.x;
+	area[1] = driver_data->options.output_area.y;
+	area[2] = driver_data->options.output_area.width;
+	area[3] = driver_data->options.output_area.height;
+
+	LibinputMakeProperty(dev, prop_output_area,
+			     XA_CARDINAL, 32,
+			     4, area);
 }
 
 static void
@@ -2161,18 +5138,18 @@ LibinputInitAccelProperty(DeviceIntPtr dev,
 	if (!libinput_device_config_accel_is_available(device))
 		return;
 
-	prop_accel = LibinputMakeProperty(dev,
-					  LIBINPUT_PROP_ACCEL,
-					  prop_float, 32,
-					  1, &speed);
-	if (!prop_accel)
+	if (!LibinputMakeProperty(dev, prop_accel,
+				  prop_float, 32,
+				  1, &speed))
+		return;
+
+	if (driver_data->options.compact_properties)
 		return;
 
 	speed = libinput_device_config_accel_get_default_speed(device);
-	prop_accel_default = LibinputMakeProperty(dev,
-						  LIBINPUT_PROP_ACCEL_DEFAULT,
-						  prop_float, 32,
-						  1, &speed);
+	LibinputMakeProperty(dev, prop_accel_default,
+			     prop_float, 32,
+			     1, &speed);
 }
 
 static void
@@ -2185,18 +5162,18 @@ LibinputInitNaturalScrollProperty(DeviceIntPtr dev,
 	if (!libinput_device_config_scroll_has_natural_scroll(device))
 		return;
 
-	prop_natural_scroll = LibinputMakeProperty(dev,
-						   LIBINPUT_PROP_NATURAL_SCROLL,
-						   XA_INTEGER, 8,
-						   1, &natural_scroll);
-	if (!prop_natural_scroll)
+	if (!LibinputMakeProperty(dev, prop_natural_scroll,
+				  XA_INTEGER, 8,
+				  1, &natural_scroll))
+		return;
+
+	if (driver_data->options.compact_properties)
 		return;
 
 	natural_scroll = libinput_device_config_scroll_get_default_natural_scroll_enabled(device);
-	prop_natural_scroll_default = LibinputMakeProperty(dev,
-							   LIBINPUT_PROP_NATURAL_SCROLL_DEFAULT,
-							   XA_INTEGER, 8,
-							   1, &natural_scroll);
+	LibinputMakeProperty(dev, prop_natural_scroll_default,
+			     XA_INTEGER, 8,
+			     1, &natural_scroll);
 }
 
 static void
@@ -2217,11 +5194,10 @@ LibinputInitSendEventsProperty(DeviceIntPtr dev,
 	if (sendevent_modes & LIBINPUT_CONFIG_SEND_EVENTS_DISABLED_ON_EXTERNAL_MOUSE)
 		modes[1] = TRUE;
 
-	prop_sendevents_available = LibinputMakeProperty(dev,
-							 LIBINPUT_PROP_SENDEVENTS_AVAILABLE,
-							 XA_INTEGER, 8,
-							 2, modes);
-	if (!prop_sendevents_available)
+	if (!driver_data->options.compact_properties &&
+	    !LibinputMakeProperty(dev, prop_sendevents_available,
+				  XA_INTEGER, 8,
+				  2, modes))
 		return;
 
 	memset(modes, 0, sizeof(modes));
@@ -2236,12 +5212,12 @@ LibinputInitSendEventsProperty(DeviceIntPtr dev,
 		break;
 	}
 
-	prop_sendevents_enabled = LibinputMakeProperty(dev,
-						       LIBINPUT_PROP_SENDEVENTS_ENABLED,
-						       XA_INTEGER, 8,
-						       2, modes);
+	if (!LibinputMakeProperty(dev, prop_sendevents_enabled,
+				  XA_INTEGER, 8,
+				  2, modes))
+		return;
 
-	if (!prop_sendevents_enabled)
+	if (driver_data->options.compact_properties)
 		return;
 
 	memset(modes, 0, sizeof(modes));
@@ -2251,10 +5227,9 @@ LibinputInitSendEventsProperty(DeviceIntPtr dev,
 	if (sendevent_modes & LIBINPUT_CONFIG_SEND_EVENTS_DISABLED_ON_EXTERNAL_MOUSE)
 		modes[1] = TRUE;
 
-	prop_sendevents_default = LibinputMakeProperty(dev,
-						       LIBINPUT_PROP_SENDEVENTS_ENABLED_DEFAULT,
-						       XA_INTEGER, 8,
-						       2, modes);
+	LibinputMakeProperty(dev, prop_sendevents_default,
+			     XA_INTEGER, 8,
+			     2, modes);
 }
 
 static void
@@ -2267,18 +5242,18 @@ LibinputInitLeftHandedProperty(DeviceIntPtr dev,
 	if (!libinput_device_config_left_handed_is_available(device))
 		return;
 
-	prop_left_handed = LibinputMakeProperty(dev,
-						LIBINPUT_PROP_LEFT_HANDED,
-						XA_INTEGER, 8,
-						1, &left_handed);
-	if (!prop_left_handed)
+	if (!LibinputMakeProperty(dev, prop_left_handed,
+				  XA_INTEGER, 8,
+				  1, &left_handed))
+		return;
+
+	if (driver_data->options.compact_properties)
 		return;
 
 	left_handed = libinput_device_config_left_handed_get_default(device);
-	prop_left_handed_default = LibinputMakeProperty(dev,
-							LIBINPUT_PROP_LEFT_HANDED_DEFAULT,
-							XA_INTEGER, 8,
-							1, &left_handed);
+	LibinputMakeProperty(dev, prop_left_handed_default,
+			     XA_INTEGER, 8,
+			     1, &left_handed);
 }
 
 static void
@@ -2301,12 +5276,11 @@ LibinputInitScrollMethodsProperty(DeviceIntPtr dev,
 	if (scroll_methods & LIBINPUT_CONFIG_SCROLL_ON_BUTTON_DOWN)
 		methods[2] = TRUE;
 
-	prop_scroll_methods_available = LibinputMakeProperty(dev,
-							     LIBINPUT_PROP_SCROLL_METHODS_AVAILABLE,
-							     XA_INTEGER, 8,
-							     ARRAY_SIZE(methods),
-							     &methods);
-	if (!prop_scroll_methods_available)
+	if (!driver_data->options.compact_properties &&
+	    !LibinputMakeProperty(dev, prop_scroll_methods_available,
+				  XA_INTEGER, 8,
+				  ARRAY_SIZE(methods),
+				  &methods))
 		return;
 
 	memset(methods, 0, sizeof(methods));
@@ -2326,44 +5300,44 @@ LibinputInitScrollMethodsProperty(DeviceIntPtr dev,
 		break;
 	}
 
-	prop_scroll_method_enabled = LibinputMakeProperty(dev,
-							  LIBINPUT_PROP_SCROLL_METHOD_ENABLED,
-							  XA_INTEGER, 8,
-							  ARRAY_SIZE(methods),
-							  &methods);
-	if (!prop_scroll_method_enabled)
+	if (!LibinputMakeProperty(dev, prop_scroll_method_enabled,
+				  XA_INTEGER, 8,
+				  ARRAY_SIZE(methods),
+				  &methods))
 		return;
 
-	scroll_methods = libinput_device_config_scroll_get_default_method(device);
-	if (scroll_methods & LIBINPUT_CONFIG_SCROLL_2FG)
-		methods[0] = TRUE;
-	if (scroll_methods & LIBINPUT_CONFIG_SCROLL_EDGE)
-		methods[1] = TRUE;
-	if (scroll_methods & LIBINPUT_CONFIG_SCROLL_ON_BUTTON_DOWN)
-		methods[2] = TRUE;
+	if (!driver_data->options.compact_properties) {
+		scroll_methods = libinput_device_config_scroll_get_default_method(device);
+		if (scroll_methods & LIBINPUT_CONFIG_SCROLL_2FG)
+			methods[0] = TRUE;
+		if (scroll_methods & LIBINPUT_CONFIG_SCROLL_EDGE)
+			methods[1] = TRUE;
+		if (scroll_methods & LIBINPUT_CONFIG_SCROLL_ON_BUTTON_DOWN)
+			methods[2] = TRUE;
+
+		LibinputMakeProperty(dev, prop_scroll_method_default,
+				     XA_INTEGER, 8,
+				     ARRAY_SIZE(methods),
+				     &methods);
+	}
 
-	prop_scroll_method_default = LibinputMakeProperty(dev,
-							  LIBINPUT_PROP_SCROLL_METHOD_ENABLED_DEFAULT,
-							  XA_INTEGER, 8,
-							  ARRAY_SIZE(methods),
-							  &methods);
 	/* Scroll button */
 	if (libinput_device_config_scroll_get_methods(device) &
 	    LIBINPUT_CONFIG_SCROLL_ON_BUTTON_DOWN) {
 		CARD32 scroll_button = driver_data->options.scroll_button;
 
-		prop_scroll_button = LibinputMakeProperty(dev,
-							  LIBINPUT_PROP_SCROLL_BUTTON,
-							  XA_CARDINAL, 32,
-							  1, &scroll_button);
-		if (!prop_scroll_button)
+		if (!LibinputMakeProperty(dev, prop_scroll_button,
+					  XA_CARDINAL, 32,
+					  1, &scroll_button))
+			return;
+
+		if (driver_data->options.compact_properties)
 			return;
 
 		scroll_button = libinput_device_config_scroll_get_default_button(device);
-		prop_scroll_button_default = LibinputMakeProperty(dev,
-								  LIBINPUT_PROP_SCROLL_BUTTON_DEFAULT,
-								  XA_CARDINAL, 32,
-								  1, &scroll_button);
+		LibinputMakeProperty(dev, prop_scroll_button_default,
+				     XA_CARDINAL, 32,
+				     1, &scroll_button);
 	}
 }
 
@@ -2385,12 +5359,11 @@ LibinputInitClickMethodsProperty(DeviceIntPtr dev,
 	if (click_methods & LIBINPUT_CONFIG_CLICK_METHOD_CLICKFINGER)
 		methods[1] = TRUE;
 
-	prop_click_methods_available = LibinputMakeProperty(dev,
-							    LIBINPUT_PROP_CLICK_METHODS_AVAILABLE,
-							    XA_INTEGER, 8,
-							    ARRAY_SIZE(methods),
-							    &methods);
-	if (!prop_click_methods_available)
+	if (!driver_data->options.compact_properties &&
+	    !LibinputMakeProperty(dev, prop_click_methods_available,
+				  XA_INTEGER, 8,
+				  ARRAY_SIZE(methods),
+				  &methods))
 		return;
 
 	memset(methods, 0, sizeof(methods));
@@ -2407,13 +5380,13 @@ LibinputInitClickMethodsProperty(DeviceIntPtr dev,
 		break;
 	}
 
-	prop_click_method_enabled = LibinputMakeProperty(dev,
-							 LIBINPUT_PROP_CLICK_METHOD_ENABLED,
-							 XA_INTEGER, 8,
-							 ARRAY_SIZE(methods),
-							 &methods);
+	if (!LibinputMakeProperty(dev, prop_click_method_enabled,
+				  XA_INTEGER, 8,
+				  ARRAY_SIZE(methods),
+				  &methods))
+		return;
 
-	if (!prop_click_method_enabled)
+	if (driver_data->options.compact_properties)
 		return;
 
 	memset(methods, 0, sizeof(methods));
@@ -2430,11 +5403,10 @@ LibinputInitClickMethodsProperty(DeviceIntPtr dev,
 		break;
 	}
 
-	prop_click_method_default = LibinputMakeProperty(dev,
-							 LIBINPUT_PROP_CLICK_METHOD_ENABLED_DEFAULT,
-							 XA_INTEGER, 8,
-							 ARRAY_SIZE(methods),
-							 &methods);
+	LibinputMakeProperty(dev, prop_click_method_default,
+			     XA_INTEGER, 8,
+			     ARRAY_SIZE(methods),
+			     &methods);
 }
 
 static void
@@ -2447,20 +5419,195 @@ LibinputInitMiddleEmulationProperty(DeviceIntPtr dev,
 	if (!libinput_device_config_middle_emulation_is_available(device))
 		return;
 
-	prop_middle_emulation = LibinputMakeProperty(dev,
-						     LIBINPUT_PROP_MIDDLE_EMULATION_ENABLED,
-						     XA_INTEGER,
-						     8,
-						     1,
-						     &middle);
-	if (!prop_middle_emulation)
+	if (!LibinputMakeProperty(dev, prop_middle_emulation,
+				  XA_INTEGER, 8,
+				  1, &middle))
+		return;
+
+	if (driver_data->options.compact_properties)
 		return;
 
 	middle = libinput_device_config_middle_emulation_get_default_enabled(device);
-	prop_middle_emulation_default = LibinputMakeProperty(dev,
-							     LIBINPUT_PROP_MIDDLE_EMULATION_ENABLED_DEFAULT,
-							     XA_INTEGER, 8,
-							     1, &middle);
+	LibinputMakeProperty(dev, prop_middle_emulation_default,
+			     XA_INTEGER, 8,
+			     1, &middle);
+}
+
+static void
+LibinputInitLogPriorityProperty(DeviceIntPtr dev,
+				struct xf86libinput *driver_data,
+				struct libinput_device *device)
+{
+	CARD32 priority = driver_context.log_priority_override;
+
+	LibinputMakeProperty(dev, prop_log_priority,
+			     XA_CARDINAL, 32,
+			     1, &priority);
+}
+
+static void
+LibinputInitFlightRecorderProperty(DeviceIntPtr dev,
+				   struct xf86libinput *driver_data,
+				   struct libinput_device *device)
+{
+	BOOL dump = FALSE;
+
+	LibinputMakeProperty(dev, prop_flight_recorder_dump,
+			     XA_INTEGER, 8,
+			     1, &dump);
+}
+
+static void
+LibinputInitStatisticsProperty(DeviceIntPtr dev,
+			       struct xf86libinput *driver_data,
+			       struct libinput_device *device)
+{
+	CARD32 stats[5] = {0};
+
+	LibinputMakeProperty(dev, prop_statistics,
+			     XA_CARDINAL, 32,
+			     ARRAY_SIZE(stats), stats);
+}
+
+static void
+LibinputInitDrainStatisticsProperty(DeviceIntPtr dev,
+				    struct xf86libinput *driver_data,
+				    struct libinput_device *device)
+{
+	CARD32 stats[3 + DRAIN_HISTOGRAM_SIZE] = {0};
+
+	LibinputMakeProperty(dev, prop_drain_statistics,
+			     XA_CARDINAL, 32,
+			     ARRAY_SIZE(stats), stats);
+}
+
+static void
+LibinputInitConfigBatchProperty(DeviceIntPtr dev,
+				struct xf86libinput *driver_data,
+				struct libinput_device *device)
+{
+	CARD32 empty = 0;
+
+	LibinputMakeProperty(dev, prop_config_batch,
+			     XA_INTEGER, 32,
+			     0, &empty);
+}
+
+static void
+LibinputInitFloodProperty(DeviceIntPtr dev,
+			  struct xf86libinput *driver_data,
+			  struct libinput_device *device)
+{
+	CARD32 flood[3] = {0};
+
+	if (driver_data->flood.threshold == 0)
+		return;
+
+	flood[0] = driver_data->flood.threshold;
+
+	LibinputMakeProperty(dev, prop_flood,
+			     XA_CARDINAL, 32,
+			     ARRAY_SIZE(flood), flood);
+}
+
+static void
+LibinputInitDefaultsProperty(DeviceIntPtr dev,
+			     struct xf86libinput *driver_data,
+			     struct libinput_device *device)
+{
+	float defaults[13 + 9] = {0};
+
+	if (!driver_data->options.compact_properties)
+		return;
+
+	if (libinput_device_config_tap_get_finger_count(device) > 0) {
+		defaults[0] = libinput_device_config_tap_get_default_enabled(device);
+		defaults[1] = libinput_device_config_tap_get_default_drag_lock_enabled(device);
+	}
+	if (libinput_device_config_scroll_has_natural_scroll(device))
+		defaults[2] = libinput_device_config_scroll_get_default_natural_scroll_enabled(device);
+	if (libinput_device_config_left_handed_is_available(device))
+		defaults[3] = libinput_device_config_left_handed_get_default(device);
+	if (libinput_device_config_middle_emulation_is_available(device))
+		defaults[4] = libinput_device_config_middle_emulation_get_default_enabled(device);
+	if (libinput_device_config_accel_is_available(device))
+		defaults[5] = libinput_device_config_accel_get_default_speed(device);
+
+	defaults[6] = libinput_device_config_send_events_get_modes(device);
+	defaults[7] = libinput_device_config_send_events_get_default_mode(device);
+	defaults[8] = libinput_device_config_scroll_get_methods(device);
+	defaults[9] = libinput_device_config_scroll_get_default_method(device);
+	if (libinput_device_config_scroll_get_methods(device) &
+	    LIBINPUT_CONFIG_SCROLL_ON_BUTTON_DOWN)
+		defaults[10] = btn_linux2xorg(libinput_device_config_scroll_get_default_button(device));
+	defaults[11] = libinput_device_config_click_get_methods(device);
+	defaults[12] = libinput_device_config_click_get_default_method(device);
+
+	if (libinput_device_config_calibration_has_matrix(device)) {
+		libinput_device_config_calibration_get_default_matrix(device,
+								      &defaults[13]);
+		defaults[13 + 6] = 0;
+		defaults[13 + 7] = 0;
+		defaults[13 + 8] = 1;
+	}
+
+	LibinputMakeProperty(dev, prop_defaults,
+			     prop_float, 32,
+			     ARRAY_SIZE(defaults), defaults);
+}
+
+static void
+LibinputInitKineticScrollingProperty(DeviceIntPtr dev,
+				     struct xf86libinput *driver_data,
+				     struct libinput_device *device)
+{
+	CARD32 kinetic[3];
+
+	/* only two-finger and edge scrolling send finger axis events */
+	if ((libinput_device_config_scroll_get_methods(device) &
+	     (LIBINPUT_CONFIG_SCROLL_2FG|LIBINPUT_CONFIG_SCROLL_EDGE)) == 0)
+		return;
+
+	kinetic[0] = driver_data->kinetic.enabled;
+	kinetic[1] = driver_data->kinetic.time_constant;
+	kinetic[2] = driver_data->kinetic.interval;
+
+	LibinputMakeProperty(dev, prop_kinetic,
+			     XA_CARDINAL, 32,
+			     ARRAY_SIZE(kinetic), kinetic);
+}
+
+static void
+LibinputInitScrollDistanceProperty(DeviceIntPtr dev,
+				   struct xf86libinput *driver_data,
+				   struct libinput_device *device)
+{
+	CARD32 dist[2];
+
+	/* only pointer devices have scroll valuators */
+	if (!libinput_device_has_capability(device, LIBINPUT_DEVICE_CAP_POINTER))
+		return;
+
+	dist[0] = driver_data->core.scroll.vdist;
+	dist[1] = driver_data->core.scroll.hdist;
+
+	LibinputMakeProperty(dev, prop_scroll_distance,
+			     XA_CARDINAL, 32,
+			     ARRAY_SIZE(dist), dist);
+}
+
+static void
+LibinputInitSummaryProperty(DeviceIntPtr dev,
+			    struct xf86libinput *driver_data,
+			    struct libinput_device *device)
+{
+	CARD32 summary[SUMMARY_SIZE];
+
+	LibinputFillSummary(driver_data, device, summary);
+
+	LibinputMakeProperty(dev, prop_summary,
+			     XA_CARDINAL, 32,
+			     ARRAY_SIZE(summary), summary);
 }
 
 static void
@@ -2471,13 +5618,14 @@ LibinputInitProperty(DeviceIntPtr dev)
 	struct libinput_device *device = driver_data->device;
 	const char *device_node;
 	CARD32 product[2];
-	int rc;
 
-	prop_float = XIGetKnownProperty("FLOAT");
+	driver_data->props = 0;
+	LibinputInitAtoms();
 
 	LibinputInitTapProperty(dev, driver_data, device);
 	LibinputInitTapDragLockProperty(dev, driver_data, device);
 	LibinputInitCalibrationProperty(dev, driver_data, device);
+	LibinputInitOutputAreaProperty(dev, driver_data, device);
 	LibinputInitAccelProperty(dev, driver_data, device);
 	LibinputInitNaturalScrollProperty(dev, driver_data, device);
 	LibinputInitSendEventsProperty(dev, driver_data, device);
@@ -2485,30 +5633,27 @@ LibinputInitProperty(DeviceIntPtr dev)
 	LibinputInitScrollMethodsProperty(dev, driver_data, device);
 	LibinputInitClickMethodsProperty(dev, driver_data, device);
 	LibinputInitMiddleEmulationProperty(dev, driver_data, device);
+	LibinputInitLogPriorityProperty(dev, driver_data, device);
+	LibinputInitFlightRecorderProperty(dev, driver_data, device);
+	LibinputInitStatisticsProperty(dev, driver_data, device);
+	LibinputInitFloodProperty(dev, driver_data, device);
+	LibinputInitDrainStatisticsProperty(dev, driver_data, device);
+	LibinputInitConfigBatchProperty(dev, driver_data, device);
+	LibinputInitDefaultsProperty(dev, driver_data, device);
+	LibinputInitSummaryProperty(dev, driver_data, device);
+	LibinputInitKineticScrollingProperty(dev, driver_data, device);
+	LibinputInitScrollDistanceProperty(dev, driver_data, device);
 
 	/* Device node property, read-only  */
 	device_node = driver_data->path;
-	prop_device = MakeAtom(XI_PROP_DEVICE_NODE,
-			       strlen(XI_PROP_DEVICE_NODE),
-			       TRUE);
-	rc = XIChangeDeviceProperty(dev, prop_device, XA_STRING, 8,
-				    PropModeReplace,
-				    strlen(device_node), device_node,
-				    FALSE);
-	if (rc != Success)
+	if (!LibinputMakeProperty(dev, prop_device,
+				  XA_STRING, 8,
+				  strlen(device_node), (void*)device_node))
 		return;
 
-	XISetDevicePropertyDeletable(dev, prop_device, FALSE);
-
-	prop_product_id = MakeAtom(XI_PROP_PRODUCT_ID,
-				   strlen(XI_PROP_PRODUCT_ID),
-				   TRUE);
 	product[0] = libinput_device_get_id_vendor(device);
 	product[1] = libinput_device_get_id_product(device);
-	rc = XIChangeDeviceProperty(dev, prop_product_id, XA_INTEGER, 32,
-				    PropModeReplace, 2, product, FALSE);
-	if (rc != Success)
-		return;
-
-	XISetDevicePropertyDeletable(dev, prop_product_id, FALSE);
+	LibinputMakeProperty(dev, prop_product_id,
+			     XA_INTEGER, 32,
+			     2, product);
 }
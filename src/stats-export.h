@@ -0,0 +1,121 @@
+/*
+ * Copyright © 2015 Red Hat, Inc.
+ *
+ * Permission to use, copy, modify, distribute, and sell this software
+ * and its documentation for any purpose is hereby granted without
+ * fee, provided that the above copyright notice appear in all copies
+ * and that both that copyright notice and this permission notice
+ * appear in supporting documentation, and that the name of Red Hat
+ * not be used in advertising or publicity pertaining to distribution
+ * of the software without specific, written prior permission.  Red
+ * Hat makes no representations about the suitability of this software
+ * for any purpose.  It is provided "as is" without express or implied
+ * warranty.
+ *
+ * THE AUTHORS DISCLAIM ALL WARRANTIES WITH REGARD TO THIS SOFTWARE,
+ * INCLUDING ALL IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS, IN
+ * NO EVENT SHALL THE AUTHORS BE LIABLE FOR ANY SPECIAL, INDIRECT OR
+ * CONSEQUENTIAL DAMAGES OR ANY DAMAGES WHATSOEVER RESULTING FROM LOSS
+ * OF USE, DATA OR PROFITS, WHETHER IN AN ACTION OF CONTRACT,
+ * NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF OR IN
+ * CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+ */
+
+#ifndef _STATS_EXPORT_H_
+#define _STATS_EXPORT_H_
+
+/*
+   Layout of the statistics file written if the StatisticsDirectory option
+   is set. The file is memory-mapped by the driver and updated once per
+   read of the libinput fd, readers map it read-only.
+
+   The file starts with a struct stats_export_header, followed by
+   max_devices slots of device_size bytes each, starting at header_size.
+   Fields are only ever appended, a reader must check magic and version
+   and use the sizes from the header rather than sizeof.
+
+   The header's counters and each device slot are protected by a
+   sequence number that is odd while the driver is writing. A reader
+   reads the sequence number, copies the data and reads the sequence
+   number again, and retries if it was odd or has changed.
+ */
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#define STATS_EXPORT_MAGIC 0x4c495354 /* "LIST" */
+#define STATS_EXPORT_VERSION 1
+#define STATS_EXPORT_MAX_DEVICES 64
+#define STATS_EXPORT_DRAIN_BUCKETS 12 /* 0, 1, 2-3, ..., 1024+ events */
+#define STATS_EXPORT_LATENCY_BUCKETS 8 /* 0, 1, 2-3, ..., 64+ ms */
+
+enum stats_export_event_type {
+	STATS_EXPORT_EVENT_MOTION,
+	STATS_EXPORT_EVENT_MOTION_ABSOLUTE,
+	STATS_EXPORT_EVENT_BUTTON,
+	STATS_EXPORT_EVENT_KEY,
+	STATS_EXPORT_EVENT_AXIS,
+	STATS_EXPORT_EVENT_TOUCH,
+	STATS_EXPORT_EVENT_OTHER,
+	STATS_EXPORT_EVENT_TYPES,
+};
+
+struct stats_export_header {
+	uint32_t magic;
+	uint32_t version;
+	uint32_t header_size;
+	uint32_t device_size;
+	uint32_t max_devices;
+	uint32_t seq;
+	/* same as the libinput Drain Statistics property */
+	uint64_t wakeups;
+	uint64_t eagain;
+	uint64_t drain[STATS_EXPORT_DRAIN_BUCKETS];
+	uint64_t log_suppressed;
+};
+
+struct stats_export_device {
+	uint32_t seq;
+	int32_t id; /* X device id, -1 if the slot is unused */
+	char name[64];
+	uint64_t events[STATS_EXPORT_EVENT_TYPES];
+	/* motion events dropped because the position didn't change */
+	uint64_t suppressed_motion;
+	/* motion events dropped because the device was throttled */
+	uint64_t throttled_motion;
+	uint64_t config_applied;
+	/* time between the kernel event and the driver reading it */
+	uint64_t latency[STATS_EXPORT_LATENCY_BUCKETS];
+};
+
+static inline void
+stats_export_write_begin(uint32_t *seq)
+{
+	__atomic_store_n(seq, *seq + 1, __ATOMIC_RELAXED);
+	__atomic_thread_fence(__ATOMIC_RELEASE);
+}
+
+static inline void
+stats_export_write_end(uint32_t *seq)
+{
+	__atomic_store_n(seq, *seq + 1, __ATOMIC_RELEASE);
+}
+
+/* Returns false if the driver is currently writing */
+static inline bool
+stats_export_read_begin(const uint32_t *seq, uint32_t *start)
+{
+	*start = __atomic_load_n(seq, __ATOMIC_ACQUIRE);
+	return (*start & 1) == 0;
+}
+
+/* Returns true if the data copied since stats_export_read_begin() is
+   consistent */
+static inline bool
+stats_export_read_end(const uint32_t *seq, uint32_t start)
+{
+	__atomic_thread_fence(__ATOMIC_ACQUIRE);
+	return __atomic_load_n(seq, __ATOMIC_RELAXED) == start;
+}
+
+#endif /* _STATS_EXPORT_H_ */
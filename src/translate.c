@@ -0,0 +1,335 @@
+/*
+ * Copyright © 2015 Red Hat, Inc.
+ *
+ * Permission to use, copy, modify, distribute, and sell this software
+ * and its documentation for any purpose is hereby granted without
+ * fee, provided that the above copyright notice appear in all copies
+ * and that both that copyright notice and this permission notice
+ * appear in supporting documentation, and that the name of Red Hat
+ * not be used in advertising or publicity pertaining to distribution
+ * of the software without specific, written prior permission.  Red
+ * Hat makes no representations about the suitability of this software
+ * for any purpose.  It is provided "as is" without express or implied
+ * warranty.
+ *
+ * THE AUTHORS DISCLAIM ALL WARRANTIES WITH REGARD TO THIS SOFTWARE,
+ * INCLUDING ALL IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS, IN
+ * NO EVENT SHALL THE AUTHORS BE LIABLE FOR ANY SPECIAL, INDIRECT OR
+ * CONSEQUENTIAL DAMAGES OR ANY DAMAGES WHATSOEVER RESULTING FROM LOSS
+ * OF USE, DATA OR PROFITS, WHETHER IN AN ACTION OF CONTRACT,
+ * NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF OR IN
+ * CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+ */
+
+#ifdef HAVE_CONFIG_H
+#include "config.h"
+#endif
+
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "translate.h"
+
+#define BUTTON_MAP_MAX 32
+
+static inline void
+post_init(struct translate_post *post, enum translate_post_type type)
+{
+	post->type = type;
+	post->mask = 0;
+	post->has_unaccel = false;
+	post->code = 0;
+	post->state = 0;
+}
+
+static inline void
+post_set(struct translate_post *post, unsigned int valuator, double value)
+{
+	post->values[valuator] = value;
+	post->mask |= 1 << valuator;
+}
+
+/* Returns true if the position quantises to the last posted one and
+   the event can be dropped. Otherwise the position is stored as the
+   new last position. */
+static inline bool
+is_duplicate_position(struct translate_device *d,
+		      double x, double y,
+		      struct translate_position *last)
+{
+	int qx = (int)(x + 0.5),
+	    qy = (int)(y + 0.5);
+
+	if (last->valid && qx == last->x && qy == last->y) {
+		d->suppressed_motion++;
+		return true;
+	}
+
+	last->x = qx;
+	last->y = qy;
+	last->valid = true;
+
+	return false;
+}
+
+void
+translate_device_init(struct translate_device *d, int scroll_dist)
+{
+	memset(d, 0, sizeof(*d));
+	d->scroll.increment = scroll_dist;
+	d->scroll.vdist = scroll_dist;
+	d->scroll.hdist = scroll_dist;
+}
+
+void
+translate_device_reset(struct translate_device *d)
+{
+	int i;
+
+	d->abs_last.valid = false;
+	for (i = 0; i < TRANSLATE_MAX_TOUCHES; i++)
+		d->touches[i].last.valid = false;
+}
+
+bool
+translate_motion(struct translate_device *d,
+		 double dx, double dy,
+		 double dx_unaccel, double dy_unaccel,
+		 struct translate_post *post)
+{
+	post_init(post, TRANSLATE_POST_MOTION);
+	post_set(post, TRANSLATE_VALUATOR_X, dx);
+	post_set(post, TRANSLATE_VALUATOR_Y, dy);
+	post->has_unaccel = true;
+	post->unaccel[0] = dx_unaccel;
+	post->unaccel[1] = dy_unaccel;
+
+	return true;
+}
+
+bool
+translate_motion_absolute(struct translate_device *d,
+			  double x, double y,
+			  struct translate_post *post)
+{
+	if (is_duplicate_position(d, x, y, &d->abs_last))
+		return false;
+
+	post_init(post, TRANSLATE_POST_MOTION_ABSOLUTE);
+	post_set(post, TRANSLATE_VALUATOR_X, x);
+	post_set(post, TRANSLATE_VALUATOR_Y, y);
+
+	return true;
+}
+
+bool
+translate_button(struct translate_device *d,
+		 uint32_t button, bool is_press,
+		 struct translate_post *post)
+{
+	post_init(post, TRANSLATE_POST_BUTTON);
+	post->code = btn_linux2xorg(button);
+	post->state = is_press;
+
+	return true;
+}
+
+bool
+translate_key(struct translate_device *d,
+	      uint32_t key, bool is_press,
+	      struct translate_post *post)
+{
+	post_init(post, TRANSLATE_POST_KEY);
+	post->code = key + TRANSLATE_KEYCODE_OFFSET;
+	post->state = is_press;
+
+	return true;
+}
+
+bool
+translate_axis(struct translate_device *d,
+	       enum libinput_pointer_axis_source source,
+	       double vert, double vert_discrete,
+	       double horiz, double horiz_discrete,
+	       struct translate_post *post)
+{
+	switch(source) {
+		case LIBINPUT_POINTER_AXIS_SOURCE_FINGER:
+		case LIBINPUT_POINTER_AXIS_SOURCE_CONTINUOUS:
+			vert = vert * d->scroll.increment / d->scroll.vdist;
+			horiz = horiz * d->scroll.increment / d->scroll.hdist;
+			break;
+		case LIBINPUT_POINTER_AXIS_SOURCE_WHEEL:
+			vert = vert_discrete * d->scroll.increment;
+			horiz = horiz_discrete * d->scroll.increment;
+			break;
+		default:
+			return false;
+	}
+
+	post_init(post, TRANSLATE_POST_MOTION);
+	if (!isnan(vert))
+		post_set(post, TRANSLATE_VALUATOR_VSCROLL, vert);
+	if (!isnan(horiz))
+		post_set(post, TRANSLATE_VALUATOR_HSCROLL, horiz);
+
+	return true;
+}
+
+bool
+translate_touch(struct translate_device *d,
+		enum libinput_event_type type,
+		int slot, double x, double y,
+		struct translate_post *post)
+{
+	/* single-touch devices don't have slots */
+	if (slot == -1)
+		slot = 0;
+	else if (slot < 0 || slot >= TRANSLATE_MAX_TOUCHES)
+		return false;
+
+	post_init(post, TRANSLATE_POST_TOUCH);
+
+	switch (type) {
+		case LIBINPUT_EVENT_TOUCH_DOWN:
+			post->state = TRANSLATE_TOUCH_BEGIN;
+			d->touches[slot].touchid = d->next_touchid++;
+			d->touches[slot].last.valid = false;
+			break;
+		case LIBINPUT_EVENT_TOUCH_UP:
+			post->state = TRANSLATE_TOUCH_END;
+			d->touches[slot].last.valid = false;
+			break;
+		case LIBINPUT_EVENT_TOUCH_MOTION:
+			post->state = TRANSLATE_TOUCH_UPDATE;
+			break;
+		default:
+			return false;
+	}
+
+	post->code = d->touches[slot].touchid;
+
+	if (type != LIBINPUT_EVENT_TOUCH_UP) {
+		if (is_duplicate_position(d, x, y, &d->touches[slot].last))
+			return false;
+
+		post_set(post, TRANSLATE_VALUATOR_X, x);
+		post_set(post, TRANSLATE_VALUATOR_Y, y);
+	}
+
+	return true;
+}
+
+void
+translate_init_button_map(unsigned char *btnmap, size_t size)
+{
+	size_t i;
+
+	memset(btnmap, 0, size);
+	for (i = 0; i < size; i++)
+		btnmap[i] = i;
+}
+
+bool
+translate_parse_button_map(const char *str, unsigned char *btnmap, size_t size)
+{
+	const char *map = str;
+	char *s = NULL;
+	size_t idx = 1;
+
+	translate_init_button_map(btnmap, size);
+
+	do
+	{
+		unsigned long int btn = strtoul(map, &s, 10);
+
+		if (s == map || btn > BUTTON_MAP_MAX)
+		{
+			translate_init_button_map(btnmap, size);
+			return false;
+		}
+
+		btnmap[idx++] = btn;
+		map = s;
+	} while (s && *s != '\0' && idx < BUTTON_MAP_MAX && idx < size);
+
+	return true;
+}
+
+bool
+translate_parse_matrix(const char *str, float matrix[9])
+{
+	float m[9];
+
+	if (sscanf(str, "%f %f %f %f %f %f %f %f %f ",
+		   &m[0], &m[1], &m[2],
+		   &m[3], &m[4], &m[5],
+		   &m[6], &m[7], &m[8]) != 9)
+		return false;
+
+	memcpy(matrix, m, sizeof(m));
+
+	return true;
+}
+
+bool
+translate_parse_output_area(const char *str,
+			    int *x, int *y,
+			    unsigned int *width, unsigned int *height)
+{
+	unsigned int w, h;
+	int ax, ay;
+
+	if (sscanf(str, "%ux%u+%d+%d", &w, &h, &ax, &ay) != 4 ||
+	    w == 0 || h == 0)
+		return false;
+
+	*x = ax;
+	*y = ay;
+	*width = w;
+	*height = h;
+
+	return true;
+}
+
+/*
+   The calibration matrix maps into normalized desktop coordinates. If an
+   output area is set, we scale and translate the user's matrix into that
+   area of the desktop so libinput produces output-mapped coordinates
+   directly and no further transformation is needed per event.
+ */
+bool
+translate_output_area_matrix(const float m[9],
+			     int area_x, int area_y,
+			     unsigned int area_width, unsigned int area_height,
+			     int desktop_x, int desktop_y,
+			     int desktop_width, int desktop_height,
+			     float matrix[9])
+{
+	float sx, sy, tx, ty;
+
+	memcpy(matrix, m, 9 * sizeof(float));
+
+	if (area_width == 0 || area_height == 0 ||
+	    desktop_width <= 0 || desktop_height <= 0)
+		return false;
+
+	sx = (float)area_width/desktop_width;
+	sy = (float)area_height/desktop_height;
+	tx = (float)(area_x - desktop_x)/desktop_width;
+	ty = (float)(area_y - desktop_y)/desktop_height;
+
+	matrix[0] = sx * m[0];
+	matrix[1] = sx * m[1];
+	matrix[2] = sx * m[2] + tx;
+	matrix[3] = sy * m[3];
+	matrix[4] = sy * m[4];
+	matrix[5] = sy * m[5] + ty;
+	matrix[6] = 0;
+	matrix[7] = 0;
+	matrix[8] = 1;
+
+	return true;
+}
@@ -0,0 +1,226 @@
+/*
+ * Copyright © 2015 Red Hat, Inc.
+ *
+ * Permission to use, copy, modify, distribute, and sell this software
+ * and its documentation for any purpose is hereby granted without
+ * fee, provided that the above copyright notice appear in all copies
+ * and that both that copyright notice and this permission notice
+ * appear in supporting documentation, and that the name of Red Hat
+ * not be used in advertising or publicity pertaining to distribution
+ * of the software without specific, written prior permission.  Red
+ * Hat makes no representations about the suitability of this software
+ * for any purpose.  It is provided "as is" without express or implied
+ * warranty.
+ *
+ * THE AUTHORS DISCLAIM ALL WARRANTIES WITH REGARD TO THIS SOFTWARE,
+ * INCLUDING ALL IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS, IN
+ * NO EVENT SHALL THE AUTHORS BE LIABLE FOR ANY SPECIAL, INDIRECT OR
+ * CONSEQUENTIAL DAMAGES OR ANY DAMAGES WHATSOEVER RESULTING FROM LOSS
+ * OF USE, DATA OR PROFITS, WHETHER IN AN ACTION OF CONTRACT,
+ * NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF OR IN
+ * CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+ */
+
+#ifndef _TRANSLATE_H_
+#define _TRANSLATE_H_
+
+/*
+   The translation from libinput events to X events, without any
+   dependency on the X server. The driver feeds the values of each
+   libinput event in and gets back a post record describing the X event
+   to post, if any. libinput.h is only needed for its enums.
+ */
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <libinput.h>
+#include <linux/input.h>
+
+#define TRANSLATE_MAX_TOUCHES 15
+#define TRANSLATE_KEYCODE_OFFSET 8
+#define TRANSLATE_NUM_VALUATORS 4 /* x, y, hscroll, vscroll */
+
+/* Valuator numbers used in post records */
+#define TRANSLATE_VALUATOR_X 0
+#define TRANSLATE_VALUATOR_Y 1
+#define TRANSLATE_VALUATOR_HSCROLL 2
+#define TRANSLATE_VALUATOR_VSCROLL 3
+
+enum translate_post_type {
+	TRANSLATE_POST_NONE = 0,
+	TRANSLATE_POST_MOTION,		/* relative x/y or scroll valuators */
+	TRANSLATE_POST_MOTION_ABSOLUTE,	/* absolute x/y valuators */
+	TRANSLATE_POST_BUTTON,		/* code is the xorg button number */
+	TRANSLATE_POST_KEY,		/* code is the xorg keycode */
+	TRANSLATE_POST_TOUCH,		/* code is the touch id */
+};
+
+enum translate_touch_state {
+	TRANSLATE_TOUCH_BEGIN,
+	TRANSLATE_TOUCH_UPDATE,
+	TRANSLATE_TOUCH_END,
+};
+
+struct translate_post {
+	enum translate_post_type type;
+	unsigned int mask; /* bit n set if values[n] is set */
+	double values[TRANSLATE_NUM_VALUATORS];
+	/* unaccelerated x/y, only for relative motion */
+	bool has_unaccel;
+	double unaccel[2];
+	uint32_t code;
+	/* pressed for buttons and keys, translate_touch_state for touches */
+	int state;
+};
+
+struct translate_position {
+	int x;
+	int y;
+	bool valid;
+};
+
+/* Per-device translation state. This is used for every event and is
+   laid out so the fields used by pointer and keyboard devices fit into
+   the first 32 bytes, the per-touch state follows */
+struct translate_device {
+	/* the scroll valuators' increment is fixed when the device is
+	   initialised, the distances in valuator units that make one wheel
+	   click can change at any time and are scaled to the increment */
+	struct {
+		int increment;
+		int vdist;
+		int hdist;
+	} scroll;
+
+	/* last absolute position posted. Motion that quantises to the same
+	   position is dropped */
+	struct translate_position abs_last;
+
+	uint64_t suppressed_motion;
+
+	/* libinput doesn't give us hw touch ids which X expects, so
+	   emulate them here. last is the last position posted for the
+	   touch, as for abs_last */
+	unsigned int next_touchid;
+	struct {
+		unsigned int touchid;
+		struct translate_position last;
+	} touches[TRANSLATE_MAX_TOUCHES];
+};
+
+static inline unsigned int
+btn_linux2xorg(unsigned int b)
+{
+	unsigned int button;
+
+	switch(b) {
+	case 0: button = 0; break;
+	case BTN_LEFT: button = 1; break;
+	case BTN_MIDDLE: button = 2; break;
+	case BTN_RIGHT: button = 3; break;
+	default:
+		button = 8 + b - BTN_SIDE;
+		break;
+	}
+
+	return button;
+}
+static inline unsigned int
+btn_xorg2linux(unsigned int b)
+{
+	unsigned int button;
+
+	switch(b) {
+	case 0: button = 0; break;
+	case 1: button = BTN_LEFT; break;
+	case 2: button = BTN_MIDDLE; break;
+	case 3: button = BTN_RIGHT; break;
+	default:
+		button = b - 8 + BTN_SIDE;
+		break;
+	}
+
+	return button;
+}
+
+void
+translate_device_init(struct translate_device *d, int scroll_dist);
+
+/* Forget the last posted positions, call this whenever the device is
+   (re-)enabled */
+void
+translate_device_reset(struct translate_device *d);
+
+/* Each of the functions below fills in post and returns true if an
+   event is to be posted, or returns false if the event is dropped */
+bool
+translate_motion(struct translate_device *d,
+		 double dx, double dy,
+		 double dx_unaccel, double dy_unaccel,
+		 struct translate_post *post);
+
+/* x/y are already scaled into the device's axis range */
+bool
+translate_motion_absolute(struct translate_device *d,
+			  double x, double y,
+			  struct translate_post *post);
+
+bool
+translate_button(struct translate_device *d,
+		 uint32_t button, bool is_press,
+		 struct translate_post *post);
+
+bool
+translate_key(struct translate_device *d,
+	      uint32_t key, bool is_press,
+	      struct translate_post *post);
+
+/* Pass NAN for an axis the event does not have. The discrete value is
+   only used for wheel sources */
+bool
+translate_axis(struct translate_device *d,
+	       enum libinput_pointer_axis_source source,
+	       double vert, double vert_discrete,
+	       double horiz, double horiz_discrete,
+	       struct translate_post *post);
+
+/* x/y are ignored for touch up events. slot is -1 for single-touch
+   devices */
+bool
+translate_touch(struct translate_device *d,
+		enum libinput_event_type type,
+		int slot, double x, double y,
+		struct translate_post *post);
+
+/* Option string parsing. These return false if the string is invalid,
+   in which case the output is left untouched unless stated otherwise */
+
+void
+translate_init_button_map(unsigned char *btnmap, size_t size);
+
+/* On failure, btnmap is reset to the default mapping */
+bool
+translate_parse_button_map(const char *str, unsigned char *btnmap, size_t size);
+
+bool
+translate_parse_matrix(const char *str, float matrix[9]);
+
+/* "WxH+X+Y" */
+bool
+translate_parse_output_area(const char *str,
+			    int *x, int *y,
+			    unsigned int *width, unsigned int *height);
+
+/* Scale and translate matrix m so it maps into the given area of the
+   desktop instead of the whole desktop. Returns false and copies m
+   unmodified if the area or the desktop is empty */
+bool
+translate_output_area_matrix(const float m[9],
+			     int area_x, int area_y,
+			     unsigned int area_width, unsigned int area_height,
+			     int desktop_x, int desktop_y,
+			     int desktop_width, int desktop_height,
+			     float matrix[9]);
+
+#endif /* _TRANSLATE_H_ */
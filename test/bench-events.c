@@ -0,0 +1,273 @@
+/*
+ * Copyright © 2015 Red Hat, Inc.
+ *
+ * Permission to use, copy, modify, distribute, and sell this software
+ * and its documentation for any purpose is hereby granted without
+ * fee, provided that the above copyright notice appear in all copies
+ * and that both that copyright notice and this permission notice
+ * appear in supporting documentation, and that the name of Red Hat
+ * not be used in advertising or publicity pertaining to distribution
+ * of the software without specific, written prior permission.  Red
+ * Hat makes no representations about the suitability of this software
+ * for any purpose.  It is provided "as is" without express or implied
+ * warranty.
+ *
+ * THE AUTHORS DISCLAIM ALL WARRANTIES WITH REGARD TO THIS SOFTWARE,
+ * INCLUDING ALL IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS, IN
+ * NO EVENT SHALL THE AUTHORS BE LIABLE FOR ANY SPECIAL, INDIRECT OR
+ * CONSEQUENTIAL DAMAGES OR ANY DAMAGES WHATSOEVER RESULTING FROM LOSS
+ * OF USE, DATA OR PROFITS, WHETHER IN AN ACTION OF CONTRACT,
+ * NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF OR IN
+ * CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+ */
+
+/*
+   Replays synthetic event streams through the driver's event handlers
+   and prints the time per event, and times DEVICE_INIT. As in the tests,
+   the server and libinput are replaced by stubs.c: this measures the
+   driver's own work only, libinput's event processing and the server's
+   handling of the posted events are not included.
+
+   Not run by make check, the numbers depend on the machine. Build with
+   make check and run ./bench-events [events].
+ */
+
+#include "libinput.c"
+
+#include "stubs.h"
+
+#define BENCH_EVENTS 2000000
+#define BENCH_INIT_DEVICES 500
+#define SCAN_KEYS 100 /* keys of one barcode scan, press and release */
+#define TOUCH_POSITIONS 64
+
+ScreenInfo screenInfo;
+unsigned long serverGeneration = 1;
+
+#define CAP(c) (1 << LIBINPUT_DEVICE_CAP_##c)
+
+static uint64_t
+now_ns(void)
+{
+	struct timespec ts;
+
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return (uint64_t)ts.tv_sec * 1000000000 + ts.tv_nsec;
+}
+
+static InputInfoPtr
+device_add(unsigned int capabilities, int id, BOOL compact)
+{
+	InputInfoPtr pInfo;
+	DeviceIntPtr dev;
+	struct xf86libinput *driver_data;
+
+	stub_capabilities = capabilities;
+
+	pInfo = calloc(1, sizeof(*pInfo));
+	pInfo->fd = -1;
+	pInfo->name = "bench device";
+	dev = calloc(1, sizeof(*dev));
+	dev->public.devicePrivate = pInfo;
+	dev->id = id;
+	pInfo->dev = dev;
+
+	if (xf86libinput_driver.PreInit(&xf86libinput_driver, pInfo, 0) != Success) {
+		fprintf(stderr, "failed to add device\n");
+		exit(1);
+	}
+
+	driver_data = pInfo->private;
+	driver_data->options.compact_properties = compact;
+
+	if (pInfo->device_control(dev, DEVICE_INIT) != Success ||
+	    pInfo->device_control(dev, DEVICE_ON) != Success) {
+		fprintf(stderr, "failed to enable device\n");
+		exit(1);
+	}
+
+	return pInfo;
+}
+
+static void
+device_remove(InputInfoPtr pInfo)
+{
+	DeviceIntPtr dev = pInfo->dev;
+
+	pInfo->device_control(dev, DEVICE_OFF);
+	pInfo->device_control(dev, DEVICE_CLOSE);
+	xf86libinput_driver.UnInit(&xf86libinput_driver, pInfo, 0);
+	free(dev);
+}
+
+static struct libinput_device *
+device_libinput(InputInfoPtr pInfo)
+{
+	struct xf86libinput *driver_data = pInfo->private;
+
+	return driver_data->device;
+}
+
+/* relative motion, round-robin over ndevices devices */
+static void
+bench_motion(int ndevices, int nevents)
+{
+	InputInfoPtr devices[ndevices];
+	struct libinput_event *events[ndevices][2];
+	uint64_t start, end;
+	int i;
+
+	for (i = 0; i < ndevices; i++) {
+		devices[i] = device_add(CAP(POINTER), i + 2, FALSE);
+		events[i][0] = stub_motion_event(device_libinput(devices[i]), 1.5, -0.5);
+		events[i][1] = stub_motion_event(device_libinput(devices[i]), -1.5, 0.5);
+	}
+
+	start = now_ns();
+	for (i = 0; i < nevents; i++)
+		xf86libinput_handle_event(events[i % ndevices][(i / ndevices) & 1]);
+	end = now_ns();
+
+	printf("motion, %2d devices:            %6.1f ns/event\n",
+	       ndevices, (double)(end - start) / nevents);
+
+	for (i = 0; i < ndevices; i++) {
+		libinput_event_destroy(events[i][0]);
+		libinput_event_destroy(events[i][1]);
+		device_remove(devices[i]);
+	}
+}
+
+/* motion of nfingers touches, interleaved as in a touch frame */
+static void
+bench_touch(int nfingers, int nevents)
+{
+	InputInfoPtr pInfo = device_add(CAP(TOUCH), 2, FALSE);
+	struct libinput_device *device = device_libinput(pInfo);
+	struct libinput_event *events[nfingers][TOUCH_POSITIONS];
+	uint64_t start, end;
+	int slot, i;
+
+	for (slot = 0; slot < nfingers; slot++) {
+		struct libinput_event *down;
+
+		down = stub_touch_event(device, LIBINPUT_EVENT_TOUCH_DOWN,
+					slot, 0.1 * slot, 0.5);
+		xf86libinput_handle_event(down);
+		libinput_event_destroy(down);
+
+		/* every event moves the touch */
+		for (i = 0; i < TOUCH_POSITIONS; i++)
+			events[slot][i] = stub_touch_event(device,
+							   LIBINPUT_EVENT_TOUCH_MOTION,
+							   slot,
+							   0.1 * slot + 0.001 * i,
+							   0.5);
+	}
+
+	start = now_ns();
+	for (i = 0; i < nevents; i++)
+		xf86libinput_handle_event(events[i % nfingers][(i / nfingers) % TOUCH_POSITIONS]);
+	end = now_ns();
+
+	printf("touch motion, %d fingers:       %6.1f ns/event\n",
+	       nfingers, (double)(end - start) / nevents);
+
+	for (slot = 0; slot < nfingers; slot++) {
+		for (i = 0; i < TOUCH_POSITIONS; i++)
+			libinput_event_destroy(events[slot][i]);
+	}
+	device_remove(pInfo);
+}
+
+/* barcode scans of SCAN_KEYS keys each, posted as they are read or
+   collected and posted at the end of each read as in
+   xf86libinput_read_input() */
+static void
+bench_keys(BOOL burst, int nevents)
+{
+	InputInfoPtr pInfo = device_add(CAP(KEYBOARD), 2, FALSE);
+	struct xf86libinput *driver_data = pInfo->private;
+	struct libinput_event *events[SCAN_KEYS];
+	uint64_t start, end;
+	int nscans = nevents / SCAN_KEYS;
+	int i, j;
+
+	/* as parse_options() does for KeyBurstMode, freed by UnInit */
+	if (burst)
+		driver_data->burst.keys = xnfcalloc(KEY_BURST_SIZE,
+						    sizeof(*driver_data->burst.keys));
+
+	for (i = 0; i < SCAN_KEYS; i++)
+		events[i] = stub_key_event(driver_data->device,
+					   KEY_1 + (i / 2) % 10, i % 2 == 0);
+
+	start = now_ns();
+	for (i = 0; i < nscans; i++) {
+		for (j = 0; j < SCAN_KEYS; j++)
+			xf86libinput_handle_event(events[j]);
+		if (driver_data->burst.nkeys > 0)
+			xf86libinput_flush_keys(pInfo);
+	}
+	end = now_ns();
+
+	printf("keys, burst mode %-3s:           %6.1f ns/key, %.1f M keys/s\n",
+	       burst ? "on" : "off",
+	       (double)(end - start) / (nscans * SCAN_KEYS),
+	       nscans * SCAN_KEYS * 1000.0 / (end - start));
+
+	for (i = 0; i < SCAN_KEYS; i++)
+		libinput_event_destroy(events[i]);
+	device_remove(pInfo);
+}
+
+/* PreInit and DEVICE_INIT of a touchpad, with and without
+   CompactProperties */
+static void
+bench_init(BOOL compact)
+{
+	InputInfoPtr devices[BENCH_INIT_DEVICES];
+	uint64_t start, end;
+	int i;
+
+	stub_touchpad_config = 1;
+	memset(&stub_properties, 0, sizeof(stub_properties));
+
+	start = now_ns();
+	for (i = 0; i < BENCH_INIT_DEVICES; i++)
+		devices[i] = device_add(CAP(POINTER), i + 2, compact);
+	end = now_ns();
+
+	printf("touchpad init, compact %-3s:     %6.1f us/device, %u properties, %lu bytes\n",
+	       compact ? "on" : "off",
+	       (double)(end - start) / BENCH_INIT_DEVICES / 1000,
+	       stub_properties.changes / BENCH_INIT_DEVICES,
+	       stub_properties.bytes / BENCH_INIT_DEVICES);
+
+	for (i = 0; i < BENCH_INIT_DEVICES; i++)
+		device_remove(devices[i]);
+	stub_touchpad_config = 0;
+}
+
+int
+main(int argc, char **argv)
+{
+	int nevents = argc > 1 ? atoi(argv[1]) : BENCH_EVENTS;
+
+	if (nevents < SCAN_KEYS) {
+		fprintf(stderr, "Usage: %s [events]\n", argv[0]);
+		return 1;
+	}
+
+	bench_motion(1, nevents);
+	bench_motion(8, nevents);
+	bench_motion(32, nevents);
+	bench_touch(1, nevents);
+	bench_touch(5, nevents);
+	bench_keys(FALSE, nevents);
+	bench_keys(TRUE, nevents);
+	bench_init(FALSE);
+	bench_init(TRUE);
+
+	return 0;
+}
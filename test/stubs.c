@@ -0,0 +1,1205 @@
+/*
+ * Copyright © 2015 Red Hat, Inc.
+ *
+ * Permission to use, copy, modify, distribute, and sell this software
+ * and its documentation for any purpose is hereby granted without
+ * fee, provided that the above copyright notice appear in all copies
+ * and that both that copyright notice and this permission notice
+ * appear in supporting documentation, and that the name of Red Hat
+ * not be used in advertising or publicity pertaining to distribution
+ * of the software without specific, written prior permission.  Red
+ * Hat makes no representations about the suitability of this software
+ * for any purpose.  It is provided "as is" without express or implied
+ * warranty.
+ *
+ * THE AUTHORS DISCLAIM ALL WARRANTIES WITH REGARD TO THIS SOFTWARE,
+ * INCLUDING ALL IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS, IN
+ * NO EVENT SHALL THE AUTHORS BE LIABLE FOR ANY SPECIAL, INDIRECT OR
+ * CONSEQUENTIAL DAMAGES OR ANY DAMAGES WHATSOEVER RESULTING FROM LOSS
+ * OF USE, DATA OR PROFITS, WHETHER IN AN ACTION OF CONTRACT,
+ * NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF OR IN
+ * CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+ */
+
+/*
+   Minimal replacements for the X server and libinput functions the
+   driver calls, enough to run a device through its lifecycle without a
+   server or real devices. Objects are allocated for real so
+   LeakSanitizer sees what the driver fails to release, and counted in
+   stub_live.
+
+   The server headers are not included: which functions are macros or
+   inline and the exact types change between server versions. The
+   server functions are defined with ABI-compatible prototypes instead,
+   functions a given server version doesn't have are simply unused.
+ */
+
+#include <stdarg.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+#include <linux/input.h>
+#include <libinput.h>
+
+#include "stubs.h"
+
+unsigned int stub_capabilities;
+int stub_options_enabled;
+int stub_touchpad_config;
+struct stub_live stub_live;
+unsigned int stub_touch_posts[STUB_MAX_TOUCH_IDS];
+struct stub_properties stub_properties;
+
+/* server functions */
+
+typedef int Bool;
+typedef uint32_t Atom;
+typedef uint32_t CARD32;
+
+struct stub_timer {
+	int unused;
+};
+
+struct stub_mask {
+	double values[64];
+};
+
+/* same layout as XkbRMLVOSet */
+struct stub_rmlvo {
+	char *rules, *model, *layout, *variant, *options;
+};
+
+void *XNFcalloc(unsigned long amount);
+void *XNFcallocarray(size_t nmemb, size_t size);
+char *XNFstrdup(const char *s);
+char *xf86SetStrOption(void *options, const char *name, const char *deflt);
+char *xf86CheckStrOption(void *options, const char *name, const char *deflt);
+int xf86SetIntOption(void *options, const char *name, int deflt);
+int xf86SetBoolOption(void *options, const char *name, int deflt);
+double xf86SetRealOption(void *options, const char *name, double deflt);
+void *xf86ReplaceIntOption(void *options, const char *name, const int val);
+void *xf86ReplaceStrOption(void *options, const char *name, const char *val);
+void xf86IDrvMsg(void *pInfo, int type, const char *format, ...);
+void xf86IDrvMsgVerb(void *pInfo, int type, int verb, const char *format, ...);
+void xf86VIDrvMsgVerb(void *pInfo, int type, int verb, const char *format, va_list args);
+void LogMessageVerb(int type, int verb, const char *format, ...);
+void LogVMessageVerb(int type, int verb, const char *format, va_list args);
+void ErrorF(const char *format, ...);
+void ErrorFSigSafe(const char *format, ...);
+void xorg_backtrace(void);
+int xf86GetVerbosity(void);
+int xf86GetLogVerbosity(void);
+void xf86AddInputDriver(void *driver, void *module, int flags);
+void xf86DeleteInput(void *pInfo, int flags);
+void AddEnabledDevice(int fd);
+void RemoveEnabledDevice(int fd);
+Bool RegisterBlockAndWakeupHandlers(void *block, void *wakeup, void *data);
+void RemoveBlockAndWakeupHandlers(void *block, void *wakeup, void *data);
+int xf86BlockSIGIO(void);
+void xf86UnblockSIGIO(int wasset);
+void input_lock(void);
+void input_unlock(void);
+CARD32 GetTimeInMillis(void);
+void *TimerSet(void *timer, int flags, CARD32 millis, void *func, void *arg);
+void TimerCancel(void *timer);
+void TimerFree(void *timer);
+Atom MakeAtom(const char *string, unsigned len, Bool makeit);
+Atom XIGetKnownProperty(const char *name);
+int XIChangeDeviceProperty(void *dev, Atom property, Atom type, int format,
+			   int mode, unsigned long len, const void *value,
+			   Bool sendevent);
+int XIGetDeviceProperty(void *dev, Atom property, void **value);
+int XISetDevicePropertyDeletable(void *dev, Atom property, Bool deletable);
+long XIRegisterPropertyHandler(void *dev, void *set, void *get, void *delete);
+Bool InitPointerDeviceStruct(void *dev, uint8_t *map, int nbuttons,
+			     Atom *btn_labels, void *ctrl, int nmotion,
+			     int naxes, Atom *axes_labels);
+Bool InitKeyboardDeviceStruct(void *dev, void *rmlvo, void *bell, void *ctrl);
+Bool InitTouchClassDeviceStruct(void *dev, unsigned int max_touches,
+				unsigned int mode, unsigned int naxes);
+Bool xf86InitValuatorAxisStruct(void *dev, int axnum, Atom label, int minval,
+				int maxval, int resolution, int min_res,
+				int max_res, int mode);
+Bool SetScrollValuator(void *dev, int axnum, int type, double increment,
+		       int flags);
+int GetMotionHistorySize(void);
+void XkbGetRulesDflts(void *rmlvo);
+void XkbFreeRMLVOSet(void *rmlvo, Bool freeRMLVO);
+void *valuator_mask_new(int num_valuators);
+void valuator_mask_free(void **mask);
+void valuator_mask_zero(void *mask);
+void valuator_mask_set_double(void *mask, int valuator, double data);
+void valuator_mask_set_unaccelerated(void *mask, int valuator, double accel,
+				     double unaccel);
+void xf86PostMotionEventM(void *dev, int is_absolute, const void *mask);
+void xf86PostButtonEvent(void *dev, int is_absolute, int button, int is_down,
+			 int first_valuator, int num_valuators, ...);
+void xf86PostKeyboardEvent(void *dev, unsigned int key_code, int is_down);
+void xf86PostTouchEvent(void *dev, uint32_t touchid, uint16_t type,
+			uint32_t flags, const void *mask);
+
+void *
+XNFcalloc(unsigned long amount)
+{
+	return calloc(1, amount);
+}
+
+void *
+XNFcallocarray(size_t nmemb, size_t size)
+{
+	return calloc(nmemb, size);
+}
+
+char *
+XNFstrdup(const char *s)
+{
+	return s ? strdup(s) : NULL;
+}
+
+char *
+xf86SetStrOption(void *options, const char *name, const char *deflt)
+{
+	if (strcmp(name, "Device") == 0)
+		return strdup("/dev/input/event0");
+
+	return deflt ? strdup(deflt) : NULL;
+}
+
+char *
+xf86CheckStrOption(void *options, const char *name, const char *deflt)
+{
+	return xf86SetStrOption(options, name, deflt);
+}
+
+int
+xf86SetIntOption(void *options, const char *name, int deflt)
+{
+	if (stub_options_enabled && deflt < 1)
+		return 1;
+
+	return deflt;
+}
+
+int
+xf86SetBoolOption(void *options, const char *name, int deflt)
+{
+	return stub_options_enabled ? 1 : deflt;
+}
+
+double
+xf86SetRealOption(void *options, const char *name, double deflt)
+{
+	return deflt;
+}
+
+void *
+xf86ReplaceIntOption(void *options, const char *name, const int val)
+{
+	return options;
+}
+
+void *
+xf86ReplaceStrOption(void *options, const char *name, const char *val)
+{
+	return options;
+}
+
+void
+xf86IDrvMsg(void *pInfo, int type, const char *format, ...)
+{
+}
+
+void
+xf86IDrvMsgVerb(void *pInfo, int type, int verb, const char *format, ...)
+{
+}
+
+void
+xf86VIDrvMsgVerb(void *pInfo, int type, int verb, const char *format, va_list args)
+{
+}
+
+void
+LogMessageVerb(int type, int verb, const char *format, ...)
+{
+}
+
+void
+LogVMessageVerb(int type, int verb, const char *format, va_list args)
+{
+}
+
+void
+ErrorF(const char *format, ...)
+{
+}
+
+void
+ErrorFSigSafe(const char *format, ...)
+{
+}
+
+void
+xorg_backtrace(void)
+{
+}
+
+int
+xf86GetVerbosity(void)
+{
+	return 0;
+}
+
+int
+xf86GetLogVerbosity(void)
+{
+	return 0;
+}
+
+void
+xf86AddInputDriver(void *driver, void *module, int flags)
+{
+}
+
+/* UnInit hands the InputInfoRec back to the server */
+void
+xf86DeleteInput(void *pInfo, int flags)
+{
+	free(pInfo);
+}
+
+void
+AddEnabledDevice(int fd)
+{
+}
+
+void
+RemoveEnabledDevice(int fd)
+{
+}
+
+Bool
+RegisterBlockAndWakeupHandlers(void *block, void *wakeup, void *data)
+{
+	stub_live.block_handlers++;
+	return 1;
+}
+
+void
+RemoveBlockAndWakeupHandlers(void *block, void *wakeup, void *data)
+{
+	stub_live.block_handlers--;
+}
+
+int
+xf86BlockSIGIO(void)
+{
+	return 0;
+}
+
+void
+xf86UnblockSIGIO(int wasset)
+{
+}
+
+void
+input_lock(void)
+{
+}
+
+void
+input_unlock(void)
+{
+}
+
+CARD32
+GetTimeInMillis(void)
+{
+	return 0;
+}
+
+void *
+TimerSet(void *timer, int flags, CARD32 millis, void *func, void *arg)
+{
+	if (!timer) {
+		timer = calloc(1, sizeof(struct stub_timer));
+		stub_live.timers++;
+	}
+
+	return timer;
+}
+
+void
+TimerCancel(void *timer)
+{
+}
+
+void
+TimerFree(void *timer)
+{
+	if (!timer)
+		return;
+
+	free(timer);
+	stub_live.timers--;
+}
+
+/* Atoms are the index into a table of names, starting at 1 */
+Atom
+MakeAtom(const char *string, unsigned len, Bool makeit)
+{
+	static char names[512][64];
+	static Atom natoms;
+	Atom i;
+
+	for (i = 0; i < natoms; i++) {
+		if (strlen(names[i]) == len && strncmp(names[i], string, len) == 0)
+			return i + 1;
+	}
+
+	if (!makeit || natoms == 512 || len >= sizeof(names[0]))
+		return 0;
+
+	memcpy(names[natoms], string, len);
+	return ++natoms;
+}
+
+Atom
+XIGetKnownProperty(const char *name)
+{
+	return MakeAtom(name, strlen(name), 1);
+}
+
+int
+XIChangeDeviceProperty(void *dev, Atom property, Atom type, int format,
+		       int mode, unsigned long len, const void *value,
+		       Bool sendevent)
+{
+	stub_properties.changes++;
+	stub_properties.bytes += len * format / 8;
+	return 0;
+}
+
+/* BadAtom, the stubs don't store properties */
+int
+XIGetDeviceProperty(void *dev, Atom property, void **value)
+{
+	return 5;
+}
+
+int
+XISetDevicePropertyDeletable(void *dev, Atom property, Bool deletable)
+{
+	return 0;
+}
+
+long
+XIRegisterPropertyHandler(void *dev, void *set, void *get, void *delete)
+{
+	return 1;
+}
+
+Bool
+InitPointerDeviceStruct(void *dev, uint8_t *map, int nbuttons,
+			Atom *btn_labels, void *ctrl, int nmotion,
+			int naxes, Atom *axes_labels)
+{
+	return 1;
+}
+
+Bool
+InitKeyboardDeviceStruct(void *dev, void *rmlvo, void *bell, void *ctrl)
+{
+	return 1;
+}
+
+Bool
+InitTouchClassDeviceStruct(void *dev, unsigned int max_touches,
+			   unsigned int mode, unsigned int naxes)
+{
+	return 1;
+}
+
+Bool
+xf86InitValuatorAxisStruct(void *dev, int axnum, Atom label, int minval,
+			   int maxval, int resolution, int min_res,
+			   int max_res, int mode)
+{
+	return 1;
+}
+
+Bool
+SetScrollValuator(void *dev, int axnum, int type, double increment,
+		  int flags)
+{
+	return 1;
+}
+
+int
+GetMotionHistorySize(void)
+{
+	return 0;
+}
+
+void
+XkbGetRulesDflts(void *data)
+{
+	struct stub_rmlvo *rmlvo = data;
+
+	rmlvo->rules = strdup("evdev");
+	rmlvo->model = strdup("pc104");
+	rmlvo->layout = strdup("us");
+	rmlvo->variant = NULL;
+	rmlvo->options = NULL;
+}
+
+void
+XkbFreeRMLVOSet(void *data, Bool freeRMLVO)
+{
+	struct stub_rmlvo *rmlvo = data;
+
+	free(rmlvo->rules);
+	free(rmlvo->model);
+	free(rmlvo->layout);
+	free(rmlvo->variant);
+	free(rmlvo->options);
+	memset(rmlvo, 0, sizeof(*rmlvo));
+
+	if (freeRMLVO)
+		free(rmlvo);
+}
+
+void *
+valuator_mask_new(int num_valuators)
+{
+	stub_live.masks++;
+	return calloc(1, sizeof(struct stub_mask));
+}
+
+void
+valuator_mask_free(void **mask)
+{
+	if (!*mask)
+		return;
+
+	free(*mask);
+	*mask = NULL;
+	stub_live.masks--;
+}
+
+void
+valuator_mask_zero(void *mask)
+{
+	memset(mask, 0, sizeof(struct stub_mask));
+}
+
+void
+valuator_mask_set_double(void *mask, int valuator, double data)
+{
+	((struct stub_mask*)mask)->values[valuator] = data;
+}
+
+void
+valuator_mask_set_unaccelerated(void *mask, int valuator, double accel,
+				double unaccel)
+{
+	((struct stub_mask*)mask)->values[valuator] = accel;
+}
+
+void
+xf86PostMotionEventM(void *dev, int is_absolute, const void *mask)
+{
+}
+
+void
+xf86PostButtonEvent(void *dev, int is_absolute, int button, int is_down,
+		    int first_valuator, int num_valuators, ...)
+{
+}
+
+void
+xf86PostKeyboardEvent(void *dev, unsigned int key_code, int is_down)
+{
+}
+
+void
+xf86PostTouchEvent(void *dev, uint32_t touchid, uint16_t type,
+		   uint32_t flags, const void *mask)
+{
+	if (touchid < STUB_MAX_TOUCH_IDS)
+		stub_touch_posts[touchid]++;
+}
+
+/* libinput */
+
+struct libinput {
+	int refcount;
+};
+
+struct libinput_device {
+	int refcount;
+	unsigned int capabilities;
+	void *user_data;
+};
+
+/* created by stub_touch_event(), stub_motion_event() and
+   stub_key_event() */
+struct libinput_event {
+	enum libinput_event_type type;
+	struct libinput_device *device;
+	int32_t slot;
+	double x, y; /* touch: 0 to 1, motion: the deltas */
+	uint32_t key;
+	enum libinput_key_state key_state;
+};
+
+struct libinput_event_touch {
+	struct libinput_event base;
+};
+
+struct libinput_event_pointer {
+	struct libinput_event base;
+};
+
+struct libinput_event_keyboard {
+	struct libinput_event base;
+};
+
+struct libinput_event *
+stub_touch_event(struct libinput_device *device,
+		 enum libinput_event_type type,
+		 int slot, double x, double y)
+{
+	struct libinput_event *event = calloc(1, sizeof(*event));
+
+	event->type = type;
+	event->device = device;
+	event->slot = slot;
+	event->x = x;
+	event->y = y;
+
+	return event;
+}
+
+struct libinput_event *
+stub_motion_event(struct libinput_device *device, double dx, double dy)
+{
+	struct libinput_event *event = calloc(1, sizeof(*event));
+
+	event->type = LIBINPUT_EVENT_POINTER_MOTION;
+	event->device = device;
+	event->x = dx;
+	event->y = dy;
+
+	return event;
+}
+
+struct libinput_event *
+stub_key_event(struct libinput_device *device, uint32_t key, int is_press)
+{
+	struct libinput_event *event = calloc(1, sizeof(*event));
+
+	event->type = LIBINPUT_EVENT_KEYBOARD_KEY;
+	event->device = device;
+	event->key = key;
+	event->key_state = is_press ? LIBINPUT_KEY_STATE_PRESSED :
+				      LIBINPUT_KEY_STATE_RELEASED;
+
+	return event;
+}
+
+struct libinput *
+libinput_path_create_context(const struct libinput_interface *interface,
+			     void *user_data)
+{
+	struct libinput *libinput = calloc(1, sizeof(*libinput));
+
+	libinput->refcount = 1;
+	stub_live.contexts++;
+
+	return libinput;
+}
+
+struct libinput *
+libinput_ref(struct libinput *libinput)
+{
+	libinput->refcount++;
+	return libinput;
+}
+
+struct libinput *
+libinput_unref(struct libinput *libinput)
+{
+	if (!libinput || --libinput->refcount > 0)
+		return libinput;
+
+	free(libinput);
+	stub_live.contexts--;
+
+	return NULL;
+}
+
+/* the context holds the first reference, dropped again by
+   libinput_path_remove_device() */
+struct libinput_device *
+libinput_path_add_device(struct libinput *libinput, const char *path)
+{
+	struct libinput_device *device = calloc(1, sizeof(*device));
+
+	device->refcount = 1;
+	device->capabilities = stub_capabilities;
+	stub_live.devices++;
+
+	return device;
+}
+
+void
+libinput_path_remove_device(struct libinput_device *device)
+{
+	libinput_device_unref(device);
+}
+
+struct libinput_device *
+libinput_device_ref(struct libinput_device *device)
+{
+	device->refcount++;
+	return device;
+}
+
+struct libinput_device *
+libinput_device_unref(struct libinput_device *device)
+{
+	if (!device || --device->refcount > 0)
+		return device;
+
+	free(device);
+	stub_live.devices--;
+
+	return NULL;
+}
+
+int
+libinput_get_fd(struct libinput *libinput)
+{
+	return -1;
+}
+
+int
+libinput_dispatch(struct libinput *libinput)
+{
+	return 0;
+}
+
+struct libinput_event *
+libinput_get_event(struct libinput *libinput)
+{
+	return NULL;
+}
+
+void
+libinput_log_set_handler(struct libinput *libinput,
+			 libinput_log_handler log_handler)
+{
+}
+
+void
+libinput_log_set_priority(struct libinput *libinput,
+			  enum libinput_log_priority priority)
+{
+}
+
+void
+libinput_device_set_user_data(struct libinput_device *device, void *user_data)
+{
+	device->user_data = user_data;
+}
+
+void *
+libinput_device_get_user_data(struct libinput_device *device)
+{
+	return device->user_data;
+}
+
+int
+libinput_device_has_capability(struct libinput_device *device,
+			       enum libinput_device_capability capability)
+{
+	return !!(device->capabilities & (1 << capability));
+}
+
+int
+libinput_device_pointer_has_button(struct libinput_device *device, uint32_t code)
+{
+	return code >= BTN_LEFT && code <= BTN_MIDDLE;
+}
+
+unsigned int
+libinput_device_get_id_vendor(struct libinput_device *device)
+{
+	return 0;
+}
+
+unsigned int
+libinput_device_get_id_product(struct libinput_device *device)
+{
+	return 0;
+}
+
+void
+libinput_device_led_update(struct libinput_device *device,
+			   enum libinput_led leds)
+{
+}
+
+/* no configuration is available unless stub_touchpad_config is set, the
+   getters return the defaults */
+
+int
+libinput_device_config_tap_get_finger_count(struct libinput_device *device)
+{
+	return stub_touchpad_config ? 3 : 0;
+}
+
+enum libinput_config_status
+libinput_device_config_tap_set_enabled(struct libinput_device *device,
+				       enum libinput_config_tap_state enable)
+{
+	return stub_touchpad_config ?
+		LIBINPUT_CONFIG_STATUS_SUCCESS : LIBINPUT_CONFIG_STATUS_UNSUPPORTED;
+}
+
+enum libinput_config_tap_state
+libinput_device_config_tap_get_enabled(struct libinput_device *device)
+{
+	return LIBINPUT_CONFIG_TAP_DISABLED;
+}
+
+enum libinput_config_tap_state
+libinput_device_config_tap_get_default_enabled(struct libinput_device *device)
+{
+	return LIBINPUT_CONFIG_TAP_DISABLED;
+}
+
+enum libinput_config_status
+libinput_device_config_tap_set_drag_lock_enabled(struct libinput_device *device,
+						 enum libinput_config_drag_lock_state enable)
+{
+	return stub_touchpad_config ?
+		LIBINPUT_CONFIG_STATUS_SUCCESS : LIBINPUT_CONFIG_STATUS_UNSUPPORTED;
+}
+
+enum libinput_config_drag_lock_state
+libinput_device_config_tap_get_drag_lock_enabled(struct libinput_device *device)
+{
+	return LIBINPUT_CONFIG_DRAG_LOCK_DISABLED;
+}
+
+enum libinput_config_drag_lock_state
+libinput_device_config_tap_get_default_drag_lock_enabled(struct libinput_device *device)
+{
+	return LIBINPUT_CONFIG_DRAG_LOCK_DISABLED;
+}
+
+int
+libinput_device_config_calibration_has_matrix(struct libinput_device *device)
+{
+	return 0;
+}
+
+enum libinput_config_status
+libinput_device_config_calibration_set_matrix(struct libinput_device *device,
+					      const float matrix[6])
+{
+	return LIBINPUT_CONFIG_STATUS_UNSUPPORTED;
+}
+
+int
+libinput_device_config_calibration_get_matrix(struct libinput_device *device,
+					      float matrix[6])
+{
+	static const float identity[6] = { 1, 0, 0, 0, 1, 0 };
+
+	memcpy(matrix, identity, sizeof(identity));
+	return 0;
+}
+
+int
+libinput_device_config_calibration_get_default_matrix(struct libinput_device *device,
+						      float matrix[6])
+{
+	return libinput_device_config_calibration_get_matrix(device, matrix);
+}
+
+uint32_t
+libinput_device_config_send_events_get_modes(struct libinput_device *device)
+{
+	return stub_touchpad_config ?
+		LIBINPUT_CONFIG_SEND_EVENTS_DISABLED_ON_EXTERNAL_MOUSE : 0;
+}
+
+enum libinput_config_status
+libinput_device_config_send_events_set_mode(struct libinput_device *device,
+					    uint32_t mode)
+{
+	return LIBINPUT_CONFIG_STATUS_SUCCESS;
+}
+
+uint32_t
+libinput_device_config_send_events_get_mode(struct libinput_device *device)
+{
+	return 0;
+}
+
+uint32_t
+libinput_device_config_send_events_get_default_mode(struct libinput_device *device)
+{
+	return 0;
+}
+
+int
+libinput_device_config_accel_is_available(struct libinput_device *device)
+{
+	return stub_touchpad_config;
+}
+
+enum libinput_config_status
+libinput_device_config_accel_set_speed(struct libinput_device *device,
+				       double speed)
+{
+	return stub_touchpad_config ?
+		LIBINPUT_CONFIG_STATUS_SUCCESS : LIBINPUT_CONFIG_STATUS_UNSUPPORTED;
+}
+
+double
+libinput_device_config_accel_get_speed(struct libinput_device *device)
+{
+	return 0;
+}
+
+double
+libinput_device_config_accel_get_default_speed(struct libinput_device *device)
+{
+	return 0;
+}
+
+int
+libinput_device_config_scroll_has_natural_scroll(struct libinput_device *device)
+{
+	return stub_touchpad_config;
+}
+
+enum libinput_config_status
+libinput_device_config_scroll_set_natural_scroll_enabled(struct libinput_device *device,
+							 int enable)
+{
+	return stub_touchpad_config ?
+		LIBINPUT_CONFIG_STATUS_SUCCESS : LIBINPUT_CONFIG_STATUS_UNSUPPORTED;
+}
+
+int
+libinput_device_config_scroll_get_natural_scroll_enabled(struct libinput_device *device)
+{
+	return 0;
+}
+
+int
+libinput_device_config_scroll_get_default_natural_scroll_enabled(struct libinput_device *device)
+{
+	return 0;
+}
+
+int
+libinput_device_config_left_handed_is_available(struct libinput_device *device)
+{
+	return stub_touchpad_config;
+}
+
+enum libinput_config_status
+libinput_device_config_left_handed_set(struct libinput_device *device,
+				       int left_handed)
+{
+	return stub_touchpad_config ?
+		LIBINPUT_CONFIG_STATUS_SUCCESS : LIBINPUT_CONFIG_STATUS_UNSUPPORTED;
+}
+
+int
+libinput_device_config_left_handed_get(struct libinput_device *device)
+{
+	return 0;
+}
+
+int
+libinput_device_config_left_handed_get_default(struct libinput_device *device)
+{
+	return 0;
+}
+
+uint32_t
+libinput_device_config_click_get_methods(struct libinput_device *device)
+{
+	return stub_touchpad_config ?
+		LIBINPUT_CONFIG_CLICK_METHOD_BUTTON_AREAS |
+		LIBINPUT_CONFIG_CLICK_METHOD_CLICKFINGER : 0;
+}
+
+enum libinput_config_status
+libinput_device_config_click_set_method(struct libinput_device *device,
+					enum libinput_config_click_method method)
+{
+	return stub_touchpad_config ?
+		LIBINPUT_CONFIG_STATUS_SUCCESS : LIBINPUT_CONFIG_STATUS_UNSUPPORTED;
+}
+
+enum libinput_config_click_method
+libinput_device_config_click_get_method(struct libinput_device *device)
+{
+	return stub_touchpad_config ?
+		LIBINPUT_CONFIG_CLICK_METHOD_BUTTON_AREAS : LIBINPUT_CONFIG_CLICK_METHOD_NONE;
+}
+
+enum libinput_config_click_method
+libinput_device_config_click_get_default_method(struct libinput_device *device)
+{
+	return stub_touchpad_config ?
+		LIBINPUT_CONFIG_CLICK_METHOD_BUTTON_AREAS : LIBINPUT_CONFIG_CLICK_METHOD_NONE;
+}
+
+int
+libinput_device_config_middle_emulation_is_available(struct libinput_device *device)
+{
+	return stub_touchpad_config;
+}
+
+enum libinput_config_status
+libinput_device_config_middle_emulation_set_enabled(struct libinput_device *device,
+						    enum libinput_config_middle_emulation_state enable)
+{
+	return stub_touchpad_config ?
+		LIBINPUT_CONFIG_STATUS_SUCCESS : LIBINPUT_CONFIG_STATUS_UNSUPPORTED;
+}
+
+enum libinput_config_middle_emulation_state
+libinput_device_config_middle_emulation_get_enabled(struct libinput_device *device)
+{
+	return LIBINPUT_CONFIG_MIDDLE_EMULATION_DISABLED;
+}
+
+enum libinput_config_middle_emulation_state
+libinput_device_config_middle_emulation_get_default_enabled(struct libinput_device *device)
+{
+	return LIBINPUT_CONFIG_MIDDLE_EMULATION_DISABLED;
+}
+
+uint32_t
+libinput_device_config_scroll_get_methods(struct libinput_device *device)
+{
+	return stub_touchpad_config ?
+		LIBINPUT_CONFIG_SCROLL_2FG | LIBINPUT_CONFIG_SCROLL_EDGE : 0;
+}
+
+enum libinput_config_status
+libinput_device_config_scroll_set_method(struct libinput_device *device,
+					 enum libinput_config_scroll_method method)
+{
+	return stub_touchpad_config ?
+		LIBINPUT_CONFIG_STATUS_SUCCESS : LIBINPUT_CONFIG_STATUS_UNSUPPORTED;
+}
+
+enum libinput_config_scroll_method
+libinput_device_config_scroll_get_method(struct libinput_device *device)
+{
+	return stub_touchpad_config ?
+		LIBINPUT_CONFIG_SCROLL_2FG : LIBINPUT_CONFIG_SCROLL_NO_SCROLL;
+}
+
+enum libinput_config_scroll_method
+libinput_device_config_scroll_get_default_method(struct libinput_device *device)
+{
+	return stub_touchpad_config ?
+		LIBINPUT_CONFIG_SCROLL_2FG : LIBINPUT_CONFIG_SCROLL_NO_SCROLL;
+}
+
+enum libinput_config_status
+libinput_device_config_scroll_set_button(struct libinput_device *device,
+					 uint32_t button)
+{
+	return LIBINPUT_CONFIG_STATUS_UNSUPPORTED;
+}
+
+uint32_t
+libinput_device_config_scroll_get_button(struct libinput_device *device)
+{
+	return 0;
+}
+
+uint32_t
+libinput_device_config_scroll_get_default_button(struct libinput_device *device)
+{
+	return 0;
+}
+
+void
+libinput_event_destroy(struct libinput_event *event)
+{
+	free(event);
+}
+
+enum libinput_event_type
+libinput_event_get_type(struct libinput_event *event)
+{
+	return event->type;
+}
+
+struct libinput_device *
+libinput_event_get_device(struct libinput_event *event)
+{
+	return event->device;
+}
+
+struct libinput_event_pointer *
+libinput_event_get_pointer_event(struct libinput_event *event)
+{
+	return (struct libinput_event_pointer*)event;
+}
+
+struct libinput_event_keyboard *
+libinput_event_get_keyboard_event(struct libinput_event *event)
+{
+	return (struct libinput_event_keyboard*)event;
+}
+
+struct libinput_event_touch *
+libinput_event_get_touch_event(struct libinput_event *event)
+{
+	return (struct libinput_event_touch*)event;
+}
+
+/* pointer and keyboard events are never created, these are only
+   needed to link */
+
+uint32_t
+libinput_event_keyboard_get_key(struct libinput_event_keyboard *event)
+{
+	return event->base.key;
+}
+
+enum libinput_key_state
+libinput_event_keyboard_get_key_state(struct libinput_event_keyboard *event)
+{
+	return event->base.key_state;
+}
+
+uint32_t
+libinput_event_keyboard_get_time(struct libinput_event_keyboard *event)
+{
+	return 0;
+}
+
+double
+libinput_event_pointer_get_dx(struct libinput_event_pointer *event)
+{
+	return event->base.x;
+}
+
+double
+libinput_event_pointer_get_dy(struct libinput_event_pointer *event)
+{
+	return event->base.y;
+}
+
+double
+libinput_event_pointer_get_dx_unaccelerated(struct libinput_event_pointer *event)
+{
+	return event->base.x;
+}
+
+double
+libinput_event_pointer_get_dy_unaccelerated(struct libinput_event_pointer *event)
+{
+	return event->base.y;
+}
+
+double
+libinput_event_pointer_get_absolute_x_transformed(struct libinput_event_pointer *event,
+						  uint32_t width)
+{
+	return 0;
+}
+
+double
+libinput_event_pointer_get_absolute_y_transformed(struct libinput_event_pointer *event,
+						  uint32_t height)
+{
+	return 0;
+}
+
+uint32_t
+libinput_event_pointer_get_button(struct libinput_event_pointer *event)
+{
+	return 0;
+}
+
+enum libinput_button_state
+libinput_event_pointer_get_button_state(struct libinput_event_pointer *event)
+{
+	return LIBINPUT_BUTTON_STATE_RELEASED;
+}
+
+int
+libinput_event_pointer_has_axis(struct libinput_event_pointer *event,
+				enum libinput_pointer_axis axis)
+{
+	return 0;
+}
+
+double
+libinput_event_pointer_get_axis_value(struct libinput_event_pointer *event,
+				      enum libinput_pointer_axis axis)
+{
+	return 0;
+}
+
+double
+libinput_event_pointer_get_axis_value_discrete(struct libinput_event_pointer *event,
+					       enum libinput_pointer_axis axis)
+{
+	return 0;
+}
+
+enum libinput_pointer_axis_source
+libinput_event_pointer_get_axis_source(struct libinput_event_pointer *event)
+{
+	return LIBINPUT_POINTER_AXIS_SOURCE_WHEEL;
+}
+
+uint32_t
+libinput_event_pointer_get_time(struct libinput_event_pointer *event)
+{
+	return 0;
+}
+
+int32_t
+libinput_event_touch_get_slot(struct libinput_event_touch *event)
+{
+	return event->base.slot;
+}
+
+double
+libinput_event_touch_get_x_transformed(struct libinput_event_touch *event,
+				       uint32_t width)
+{
+	return event->base.x * width;
+}
+
+double
+libinput_event_touch_get_y_transformed(struct libinput_event_touch *event,
+				       uint32_t height)
+{
+	return event->base.y * height;
+}
+
+uint32_t
+libinput_event_touch_get_time(struct libinput_event_touch *event)
+{
+	return 0;
+}
@@ -0,0 +1,87 @@
+/*
+ * Copyright © 2015 Red Hat, Inc.
+ *
+ * Permission to use, copy, modify, distribute, and sell this software
+ * and its documentation for any purpose is hereby granted without
+ * fee, provided that the above copyright notice appear in all copies
+ * and that both that copyright notice and this permission notice
+ * appear in supporting documentation, and that the name of Red Hat
+ * not be used in advertising or publicity pertaining to distribution
+ * of the software without specific, written prior permission.  Red
+ * Hat makes no representations about the suitability of this software
+ * for any purpose.  It is provided "as is" without express or implied
+ * warranty.
+ *
+ * THE AUTHORS DISCLAIM ALL WARRANTIES WITH REGARD TO THIS SOFTWARE,
+ * INCLUDING ALL IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS, IN
+ * NO EVENT SHALL THE AUTHORS BE LIABLE FOR ANY SPECIAL, INDIRECT OR
+ * CONSEQUENTIAL DAMAGES OR ANY DAMAGES WHATSOEVER RESULTING FROM LOSS
+ * OF USE, DATA OR PROFITS, WHETHER IN AN ACTION OF CONTRACT,
+ * NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF OR IN
+ * CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+ */
+
+#ifndef _STUBS_H_
+#define _STUBS_H_
+
+#include <libinput.h>
+
+/*
+   Control and accounting of the server and libinput stubs in stubs.c.
+   This header must not depend on the server headers, the stubs are built
+   without them.
+ */
+
+#define STUB_MAX_TOUCH_IDS 64
+
+/* bit (1 << enum libinput_device_capability) set for each capability the
+   next libinput device added reports */
+extern unsigned int stub_capabilities;
+
+/* if set, boolean options are TRUE and integer options at least 1 instead
+   of their defaults, enabling the optional driver features */
+extern int stub_options_enabled;
+
+/* if set, the libinput devices have the configuration of a touchpad:
+   tapping, accel, natural scrolling, left-handed, click methods, middle
+   emulation, two-finger and edge scrolling and send events modes */
+extern int stub_touchpad_config;
+
+/* objects created by the stubs and not yet freed */
+struct stub_live {
+	int contexts; /* struct libinput */
+	int devices; /* struct libinput_device */
+	int timers;
+	int masks; /* ValuatorMask */
+	int block_handlers;
+};
+
+extern struct stub_live stub_live;
+
+/* XIChangeDeviceProperty calls, the stubs don't store the values */
+struct stub_properties {
+	unsigned int changes;
+	unsigned long bytes; /* of property values */
+};
+
+extern struct stub_properties stub_properties;
+
+/* xf86PostTouchEvent calls for each touch id */
+extern unsigned int stub_touch_posts[STUB_MAX_TOUCH_IDS];
+
+/* Returns a touch event from device, x and y are 0 to 1. Free with
+   libinput_event_destroy() */
+struct libinput_event *
+stub_touch_event(struct libinput_device *device,
+		 enum libinput_event_type type,
+		 int slot, double x, double y);
+
+/* Return a relative motion and a key event from device. Free with
+   libinput_event_destroy() */
+struct libinput_event *
+stub_motion_event(struct libinput_device *device, double dx, double dy);
+
+struct libinput_event *
+stub_key_event(struct libinput_device *device, uint32_t key, int is_press);
+
+#endif /* _STUBS_H_ */
@@ -0,0 +1,170 @@
+/*
+ * Copyright © 2015 Red Hat, Inc.
+ *
+ * Permission to use, copy, modify, distribute, and sell this software
+ * and its documentation for any purpose is hereby granted without
+ * fee, provided that the above copyright notice appear in all copies
+ * and that both that copyright notice and this permission notice
+ * appear in supporting documentation, and that the name of Red Hat
+ * not be used in advertising or publicity pertaining to distribution
+ * of the software without specific, written prior permission.  Red
+ * Hat makes no representations about the suitability of this software
+ * for any purpose.  It is provided "as is" without express or implied
+ * warranty.
+ *
+ * THE AUTHORS DISCLAIM ALL WARRANTIES WITH REGARD TO THIS SOFTWARE,
+ * INCLUDING ALL IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS, IN
+ * NO EVENT SHALL THE AUTHORS BE LIABLE FOR ANY SPECIAL, INDIRECT OR
+ * CONSEQUENTIAL DAMAGES OR ANY DAMAGES WHATSOEVER RESULTING FROM LOSS
+ * OF USE, DATA OR PROFITS, WHETHER IN AN ACTION OF CONTRACT,
+ * NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF OR IN
+ * CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+ */
+
+/*
+   Adds and removes devices through the full driver lifecycle, PreInit,
+   DEVICE_INIT, DEVICE_ON, DEVICE_OFF, DEVICE_CLOSE and UnInit, a few
+   thousand times. The server and libinput are replaced by stubs.c, the
+   driver code is the real one. Run under AddressSanitizer, this catches
+   use-after-free and double frees in the lifecycle, LeakSanitizer
+   reports anything not released by the end of the test. The stub
+   object counts catch leaks of the shared context before that.
+ */
+
+#include "libinput.c"
+
+#include "stubs.h"
+
+#define CHURN_CYCLES 2000
+
+ScreenInfo screenInfo;
+unsigned long serverGeneration = 1;
+
+#define CAP(c) (1 << LIBINPUT_DEVICE_CAP_##c)
+
+static const unsigned int capability_sets[] = {
+	CAP(POINTER),
+	CAP(KEYBOARD),
+	CAP(TOUCH),
+	CAP(POINTER) | CAP(KEYBOARD),
+};
+
+struct test_device {
+	InputInfoPtr pInfo;
+	DeviceIntPtr dev;
+};
+
+static int
+device_add(struct test_device *d, unsigned int capabilities, int id)
+{
+	stub_capabilities = capabilities;
+
+	d->pInfo = calloc(1, sizeof(*d->pInfo));
+	d->pInfo->fd = -1;
+	d->pInfo->name = "churn device";
+
+	if (xf86libinput_driver.PreInit(&xf86libinput_driver, d->pInfo, 0) != Success) {
+		free(d->pInfo);
+		return -1;
+	}
+
+	d->dev = calloc(1, sizeof(*d->dev));
+	d->dev->public.devicePrivate = d->pInfo;
+	d->dev->id = id;
+	d->pInfo->dev = d->dev;
+
+	if (d->pInfo->device_control(d->dev, DEVICE_INIT) != Success)
+		return -1;
+
+	return 0;
+}
+
+static int
+device_enable(struct test_device *d)
+{
+	if (d->pInfo->device_control(d->dev, DEVICE_ON) != Success)
+		return -1;
+
+	d->pInfo->read_input(d->pInfo);
+
+	return 0;
+}
+
+static void
+device_disable(struct test_device *d)
+{
+	d->pInfo->device_control(d->dev, DEVICE_OFF);
+}
+
+/* the order the server removes a device in */
+static void
+device_remove(struct test_device *d)
+{
+	d->pInfo->device_control(d->dev, DEVICE_CLOSE);
+	xf86libinput_driver.UnInit(&xf86libinput_driver, d->pInfo, 0);
+	free(d->dev);
+	d->pInfo = NULL;
+	d->dev = NULL;
+}
+
+static int
+check_released(int cycle)
+{
+	if (driver_context.libinput == NULL &&
+	    stub_live.contexts == 0 &&
+	    stub_live.devices == 0 &&
+	    stub_live.timers == 0 &&
+	    stub_live.masks == 0 &&
+	    stub_live.block_handlers == 0)
+		return 0;
+
+	fprintf(stderr,
+		"cycle %d: left behind %d contexts, %d devices, %d timers, "
+		"%d masks, %d block handlers\n",
+		cycle, stub_live.contexts, stub_live.devices,
+		stub_live.timers, stub_live.masks, stub_live.block_handlers);
+	return -1;
+}
+
+int
+main(int argc, char **argv)
+{
+	struct test_device a, b;
+	unsigned int caps;
+	int i;
+
+	for (i = 0; i < CHURN_CYCLES; i++) {
+		caps = capability_sets[i % ARRAY_SIZE(capability_sets)];
+		stub_options_enabled = (i / 4) % 2;
+
+		if (device_add(&a, caps, 2) != 0 || device_enable(&a) != 0)
+			goto fail;
+
+		/* every other cycle a second device shares the context and
+		   goes away first or last */
+		if (i % 2) {
+			caps = capability_sets[(i + 1) % ARRAY_SIZE(capability_sets)];
+			if (device_add(&b, caps, 3) != 0 || device_enable(&b) != 0)
+				goto fail;
+
+			device_disable(&b);
+			if (i % 4 == 1)
+				device_remove(&b);
+		}
+
+		device_disable(&a);
+		device_remove(&a);
+
+		if (i % 4 == 3)
+			device_remove(&b);
+
+		if (check_released(i) != 0)
+			return 1;
+	}
+
+	return 0;
+
+fail:
+	fprintf(stderr, "cycle %d: failed to add device\n", i);
+	return 1;
+}
@@ -0,0 +1,135 @@
+/*
+ * Copyright © 2015 Red Hat, Inc.
+ *
+ * Permission to use, copy, modify, distribute, and sell this software
+ * and its documentation for any purpose is hereby granted without
+ * fee, provided that the above copyright notice appear in all copies
+ * and that both that copyright notice and this permission notice
+ * appear in supporting documentation, and that the name of Red Hat
+ * not be used in advertising or publicity pertaining to distribution
+ * of the software without specific, written prior permission.  Red
+ * Hat makes no representations about the suitability of this software
+ * for any purpose.  It is provided "as is" without express or implied
+ * warranty.
+ *
+ * THE AUTHORS DISCLAIM ALL WARRANTIES WITH REGARD TO THIS SOFTWARE,
+ * INCLUDING ALL IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS, IN
+ * NO EVENT SHALL THE AUTHORS BE LIABLE FOR ANY SPECIAL, INDIRECT OR
+ * CONSEQUENTIAL DAMAGES OR ANY DAMAGES WHATSOEVER RESULTING FROM LOSS
+ * OF USE, DATA OR PROFITS, WHETHER IN AN ACTION OF CONTRACT,
+ * NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF OR IN
+ * CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+ */
+
+/*
+   Feeds interleaved multi-touch motion through a device throttled by
+   FloodThreshold and checks that every touch keeps moving, with one in
+   every decimation motion events of each touch posted.
+ */
+
+#include "libinput.c"
+
+#include "stubs.h"
+
+#define MOTION_EVENTS 120 /* per touch, divisible by every decimation */
+
+ScreenInfo screenInfo;
+unsigned long serverGeneration = 1;
+
+static void
+touch_event(InputInfoPtr pInfo, enum libinput_event_type type,
+	    int slot, double x, double y)
+{
+	struct xf86libinput *driver_data = pInfo->private;
+	struct libinput_event *event;
+
+	event = stub_touch_event(driver_data->device, type, slot, x, y);
+	xf86libinput_handle_event(event);
+	libinput_event_destroy(event);
+}
+
+/* Returns the number of touches that didn't get the expected number of
+   updates */
+static int
+test_interleaved_touches(InputInfoPtr pInfo, int ntouches,
+			 unsigned int decimation)
+{
+	struct xf86libinput *driver_data = pInfo->private;
+	unsigned int first_id = driver_data->core.next_touchid;
+	int slot, i;
+	int failed = 0;
+
+	driver_data->flood.throttled = TRUE;
+	driver_data->flood.decimation = decimation;
+	memset(stub_touch_posts, 0, sizeof(stub_touch_posts));
+
+	for (slot = 0; slot < ntouches; slot++)
+		touch_event(pInfo, LIBINPUT_EVENT_TOUCH_DOWN, slot,
+			    0.1 * slot, 0.5);
+
+	/* every event moves, so none are dropped as duplicates */
+	for (i = 1; i <= MOTION_EVENTS; i++) {
+		for (slot = 0; slot < ntouches; slot++)
+			touch_event(pInfo, LIBINPUT_EVENT_TOUCH_MOTION, slot,
+				    0.1 * slot + 0.001 * i, 0.5);
+	}
+
+	for (slot = 0; slot < ntouches; slot++)
+		touch_event(pInfo, LIBINPUT_EVENT_TOUCH_UP, slot, 0, 0);
+
+	/* begin, the updates kept, end */
+	for (slot = 0; slot < ntouches; slot++) {
+		unsigned int posts = stub_touch_posts[first_id + slot];
+		unsigned int expected = 2 + MOTION_EVENTS / decimation;
+
+		if (posts == expected)
+			continue;
+
+		fprintf(stderr,
+			"%d touches, decimation %u: touch %d posted %u events, expected %u\n",
+			ntouches, decimation, slot, posts, expected);
+		failed++;
+	}
+
+	return failed;
+}
+
+int
+main(int argc, char **argv)
+{
+	InputInfoPtr pInfo;
+	DeviceIntPtr dev;
+	int ntouches;
+	unsigned int decimation;
+	int failed = 0;
+
+	/* enables FloodThreshold */
+	stub_options_enabled = 1;
+	stub_capabilities = 1 << LIBINPUT_DEVICE_CAP_TOUCH;
+
+	pInfo = calloc(1, sizeof(*pInfo));
+	pInfo->fd = -1;
+	dev = calloc(1, sizeof(*dev));
+	dev->public.devicePrivate = pInfo;
+	pInfo->dev = dev;
+
+	if (xf86libinput_driver.PreInit(&xf86libinput_driver, pInfo, 0) != Success ||
+	    pInfo->device_control(dev, DEVICE_INIT) != Success ||
+	    pInfo->device_control(dev, DEVICE_ON) != Success) {
+		fprintf(stderr, "failed to add device\n");
+		return 1;
+	}
+
+	for (ntouches = 1; ntouches <= 4; ntouches++) {
+		for (decimation = 1; decimation <= 4; decimation++)
+			failed += test_interleaved_touches(pInfo, ntouches,
+							   decimation);
+	}
+
+	pInfo->device_control(dev, DEVICE_OFF);
+	pInfo->device_control(dev, DEVICE_CLOSE);
+	xf86libinput_driver.UnInit(&xf86libinput_driver, pInfo, 0);
+	free(dev);
+
+	return failed ? 1 : 0;
+}
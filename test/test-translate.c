@@ -0,0 +1,347 @@
+/*
+ * Copyright © 2015 Red Hat, Inc.
+ *
+ * Permission to use, copy, modify, distribute, and sell this software
+ * and its documentation for any purpose is hereby granted without
+ * fee, provided that the above copyright notice appear in all copies
+ * and that both that copyright notice and this permission notice
+ * appear in supporting documentation, and that the name of Red Hat
+ * not be used in advertising or publicity pertaining to distribution
+ * of the software without specific, written prior permission.  Red
+ * Hat makes no representations about the suitability of this software
+ * for any purpose.  It is provided "as is" without express or implied
+ * warranty.
+ *
+ * THE AUTHORS DISCLAIM ALL WARRANTIES WITH REGARD TO THIS SOFTWARE,
+ * INCLUDING ALL IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS, IN
+ * NO EVENT SHALL THE AUTHORS BE LIABLE FOR ANY SPECIAL, INDIRECT OR
+ * CONSEQUENTIAL DAMAGES OR ANY DAMAGES WHATSOEVER RESULTING FROM LOSS
+ * OF USE, DATA OR PROFITS, WHETHER IN AN ACTION OF CONTRACT,
+ * NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF OR IN
+ * CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+ */
+
+/*
+   Tests for the event translation and option parsing in
+   src/translate.c, which has no X server dependency and is linked in
+   directly.
+ */
+
+#ifdef HAVE_CONFIG_H
+#include "config.h"
+#endif
+
+#include <assert.h>
+#include <math.h>
+#include <stdio.h>
+#include <string.h>
+
+#include "translate.h"
+
+#define ARRAY_SIZE(a) (sizeof(a)/sizeof((a)[0]))
+
+static void
+test_parse_button_map(void)
+{
+	unsigned char btnmap[33];
+	unsigned char defaults[33];
+	size_t i;
+
+	translate_init_button_map(defaults, sizeof(defaults));
+	for (i = 0; i < sizeof(defaults); i++)
+		assert(defaults[i] == i);
+
+	assert(translate_parse_button_map("3 2 1", btnmap, sizeof(btnmap)));
+	assert(btnmap[0] == 0);
+	assert(btnmap[1] == 3);
+	assert(btnmap[2] == 2);
+	assert(btnmap[3] == 1);
+	/* buttons not in the string keep their default mapping */
+	assert(btnmap[4] == 4);
+	assert(btnmap[32] == 32);
+
+	assert(translate_parse_button_map("1 0 3", btnmap, sizeof(btnmap)));
+	assert(btnmap[2] == 0);
+
+	/* a map longer than the array is cut off */
+	assert(translate_parse_button_map("2 1 3 4 5 6 7 8", btnmap, 4));
+	assert(btnmap[1] == 2);
+	assert(btnmap[3] == 3);
+
+	/* invalid maps reset to the default */
+	assert(!translate_parse_button_map("", btnmap, sizeof(btnmap)));
+	assert(memcmp(btnmap, defaults, sizeof(btnmap)) == 0);
+
+	translate_parse_button_map("3 2 1", btnmap, sizeof(btnmap));
+	assert(!translate_parse_button_map("1 2 x", btnmap, sizeof(btnmap)));
+	assert(memcmp(btnmap, defaults, sizeof(btnmap)) == 0);
+
+	translate_parse_button_map("3 2 1", btnmap, sizeof(btnmap));
+	assert(!translate_parse_button_map("1 2 33", btnmap, sizeof(btnmap)));
+	assert(memcmp(btnmap, defaults, sizeof(btnmap)) == 0);
+}
+
+static void
+test_parse_output_area(void)
+{
+	struct {
+		const char *str;
+		bool valid;
+		int x, y;
+		unsigned int width, height;
+	} tests[] = {
+		{ "1920x1080+0+0", true, 0, 0, 1920, 1080 },
+		{ "1280x1024+1920+56", true, 1920, 56, 1280, 1024 },
+		{ "800x600+-800+0", true, -800, 0, 800, 600 },
+		{ "0x1080+0+0", false },
+		{ "1920x0+0+0", false },
+		{ "1920x1080", false },
+		{ "1920x1080+10", false },
+		{ "1920 1080 0 0", false },
+		{ "", false },
+	};
+	size_t i;
+
+	for (i = 0; i < ARRAY_SIZE(tests); i++) {
+		int x = -1, y = -1;
+		unsigned int width = 1, height = 1;
+		bool rc;
+
+		rc = translate_parse_output_area(tests[i].str, &x, &y,
+						 &width, &height);
+		assert(rc == tests[i].valid);
+
+		if (!rc) {
+			/* output left untouched */
+			assert(x == -1 && y == -1);
+			assert(width == 1 && height == 1);
+			continue;
+		}
+
+		assert(x == tests[i].x);
+		assert(y == tests[i].y);
+		assert(width == tests[i].width);
+		assert(height == tests[i].height);
+	}
+}
+
+static bool
+matrix_equal(const float a[9], const float b[9])
+{
+	int i;
+
+	for (i = 0; i < 9; i++) {
+		if (fabs(a[i] - b[i]) > 1e-6)
+			return false;
+	}
+
+	return true;
+}
+
+static void
+test_output_area_matrix(void)
+{
+	const float identity[9] = { 1, 0, 0,
+				    0, 1, 0,
+				    0, 0, 1 };
+	/* the right half of a 3840x1080 desktop */
+	const float right_half[9] = { 0.5, 0, 0.5,
+				      0, 1, 0,
+				      0, 0, 1 };
+	/* a 90 degree rotation */
+	const float rotated[9] = { 0, -1, 1,
+				   1, 0, 0,
+				   0, 0, 1 };
+	const float rotated_right_half[9] = { 0, -0.5, 1,
+					      1, 0, 0,
+					      0, 0, 1 };
+	/* a quarter of a desktop that doesn't start at 0/0 */
+	const float quarter[9] = { 0.5, 0, 0.5,
+				   0, 0.5, 0.5,
+				   0, 0, 1 };
+	float matrix[9];
+
+	assert(translate_output_area_matrix(identity,
+					    1920, 0, 1920, 1080,
+					    0, 0, 3840, 1080,
+					    matrix));
+	assert(matrix_equal(matrix, right_half));
+
+	assert(translate_output_area_matrix(rotated,
+					    1920, 0, 1920, 1080,
+					    0, 0, 3840, 1080,
+					    matrix));
+	assert(matrix_equal(matrix, rotated_right_half));
+
+	assert(translate_output_area_matrix(identity,
+					    0, 0, 100, 100,
+					    -100, -100, 200, 200,
+					    matrix));
+	assert(matrix_equal(matrix, quarter));
+
+	/* an empty area or desktop leaves the matrix as it is */
+	assert(!translate_output_area_matrix(rotated,
+					     0, 0, 0, 1080,
+					     0, 0, 3840, 1080,
+					     matrix));
+	assert(matrix_equal(matrix, rotated));
+
+	assert(!translate_output_area_matrix(rotated,
+					     0, 0, 1920, 1080,
+					     0, 0, 0, 0,
+					     matrix));
+	assert(matrix_equal(matrix, rotated));
+}
+
+static void
+test_motion_absolute_duplicates(void)
+{
+	struct translate_device d;
+	struct translate_post post;
+
+	translate_device_init(&d, 15);
+
+	assert(translate_motion_absolute(&d, 100.2, 200.4, &post));
+	assert(post.type == TRANSLATE_POST_MOTION_ABSOLUTE);
+	assert(post.mask == (1 << TRANSLATE_VALUATOR_X | 1 << TRANSLATE_VALUATOR_Y));
+	assert(post.values[TRANSLATE_VALUATOR_X] == 100.2);
+	assert(post.values[TRANSLATE_VALUATOR_Y] == 200.4);
+
+	/* same position after rounding */
+	assert(!translate_motion_absolute(&d, 99.6, 200.1, &post));
+	assert(!translate_motion_absolute(&d, 100.4, 199.5, &post));
+	assert(d.suppressed_motion == 2);
+
+	assert(translate_motion_absolute(&d, 100.5, 200.4, &post));
+	assert(translate_motion_absolute(&d, 100.2, 200.4, &post));
+	assert(d.suppressed_motion == 2);
+
+	/* the first event after a reset is always posted */
+	translate_device_reset(&d);
+	assert(translate_motion_absolute(&d, 100.2, 200.4, &post));
+	assert(d.suppressed_motion == 2);
+}
+
+static void
+test_touch_duplicates(void)
+{
+	struct translate_device d;
+	struct translate_post post;
+	unsigned int touchid;
+
+	translate_device_init(&d, 15);
+
+	assert(translate_touch(&d, LIBINPUT_EVENT_TOUCH_DOWN, 0, 10.2, 20.4, &post));
+	assert(post.type == TRANSLATE_POST_TOUCH);
+	assert(post.state == TRANSLATE_TOUCH_BEGIN);
+	assert(post.mask == (1 << TRANSLATE_VALUATOR_X | 1 << TRANSLATE_VALUATOR_Y));
+	touchid = post.code;
+
+	assert(!translate_touch(&d, LIBINPUT_EVENT_TOUCH_MOTION, 0, 10.4, 19.9, &post));
+	assert(d.suppressed_motion == 1);
+
+	/* a second touch at the same position is tracked separately */
+	assert(translate_touch(&d, LIBINPUT_EVENT_TOUCH_DOWN, 1, 10.2, 20.4, &post));
+	assert(post.code != touchid);
+	assert(translate_touch(&d, LIBINPUT_EVENT_TOUCH_MOTION, 1, 11, 20, &post));
+	assert(post.state == TRANSLATE_TOUCH_UPDATE);
+
+	assert(translate_touch(&d, LIBINPUT_EVENT_TOUCH_MOTION, 0, 11, 20, &post));
+	assert(post.state == TRANSLATE_TOUCH_UPDATE);
+	assert(post.code == touchid);
+	assert(post.values[TRANSLATE_VALUATOR_X] == 11);
+
+	/* touch up is never dropped and has no position */
+	assert(translate_touch(&d, LIBINPUT_EVENT_TOUCH_UP, 0, 0, 0, &post));
+	assert(post.state == TRANSLATE_TOUCH_END);
+	assert(post.code == touchid);
+	assert(post.mask == 0);
+
+	/* a new touch in the slot starts at the same position without
+	   being dropped and gets a new id */
+	assert(translate_touch(&d, LIBINPUT_EVENT_TOUCH_DOWN, 0, 11, 20, &post));
+	assert(post.code != touchid);
+	assert(d.suppressed_motion == 1);
+
+	/* single-touch devices use slot -1 */
+	assert(translate_touch(&d, LIBINPUT_EVENT_TOUCH_MOTION, -1, 30, 40, &post));
+	assert(!translate_touch(&d, LIBINPUT_EVENT_TOUCH_MOTION, -1, 30.1, 40.1, &post));
+	assert(d.suppressed_motion == 2);
+
+	assert(!translate_touch(&d, LIBINPUT_EVENT_TOUCH_MOTION,
+				TRANSLATE_MAX_TOUCHES, 50, 50, &post));
+	assert(!translate_touch(&d, LIBINPUT_EVENT_TOUCH_FRAME, 0, 50, 50, &post));
+
+	/* the first motion after a reset is always posted */
+	translate_device_reset(&d);
+	assert(translate_touch(&d, LIBINPUT_EVENT_TOUCH_MOTION, -1, 30, 40, &post));
+}
+
+static void
+test_axis_wheel_scaling(void)
+{
+	struct translate_device d;
+	struct translate_post post;
+
+	translate_device_init(&d, 15);
+
+	/* wheel events use the discrete value times the valuator increment */
+	assert(translate_axis(&d, LIBINPUT_POINTER_AXIS_SOURCE_WHEEL,
+			      10.0, 2, NAN, NAN, &post));
+	assert(post.type == TRANSLATE_POST_MOTION);
+	assert(post.mask == 1 << TRANSLATE_VALUATOR_VSCROLL);
+	assert(post.values[TRANSLATE_VALUATOR_VSCROLL] == 30);
+
+	assert(translate_axis(&d, LIBINPUT_POINTER_AXIS_SOURCE_WHEEL,
+			      NAN, NAN, -10.0, -1, &post));
+	assert(post.mask == 1 << TRANSLATE_VALUATOR_HSCROLL);
+	assert(post.values[TRANSLATE_VALUATOR_HSCROLL] == -15);
+
+	/* finger and continuous scrolling pass the value through at the
+	   default distance */
+	assert(translate_axis(&d, LIBINPUT_POINTER_AXIS_SOURCE_FINGER,
+			      3.5, 0, NAN, 0, &post));
+	assert(post.mask == 1 << TRANSLATE_VALUATOR_VSCROLL);
+	assert(post.values[TRANSLATE_VALUATOR_VSCROLL] == 3.5);
+
+	assert(translate_axis(&d, LIBINPUT_POINTER_AXIS_SOURCE_CONTINUOUS,
+			      NAN, 0, -7.25, 0, &post));
+	assert(post.mask == 1 << TRANSLATE_VALUATOR_HSCROLL);
+	assert(post.values[TRANSLATE_VALUATOR_HSCROLL] == -7.25);
+
+	/* a changed distance keeps a wheel click at one increment and scales
+	   the other sources so the distance makes up one increment */
+	d.scroll.vdist = 30;
+	d.scroll.hdist = 5;
+	assert(translate_axis(&d, LIBINPUT_POINTER_AXIS_SOURCE_WHEEL,
+			      15.0, 1, 15.0, 1, &post));
+	assert(post.mask == (1 << TRANSLATE_VALUATOR_VSCROLL |
+			     1 << TRANSLATE_VALUATOR_HSCROLL));
+	assert(post.values[TRANSLATE_VALUATOR_VSCROLL] == 15);
+	assert(post.values[TRANSLATE_VALUATOR_HSCROLL] == 15);
+
+	assert(translate_axis(&d, LIBINPUT_POINTER_AXIS_SOURCE_FINGER,
+			      30.0, 0, 5.0, 0, &post));
+	assert(post.values[TRANSLATE_VALUATOR_VSCROLL] == 15);
+	assert(post.values[TRANSLATE_VALUATOR_HSCROLL] == 15);
+
+	assert(translate_axis(&d, LIBINPUT_POINTER_AXIS_SOURCE_CONTINUOUS,
+			      -6.0, 0, NAN, 0, &post));
+	assert(post.mask == 1 << TRANSLATE_VALUATOR_VSCROLL);
+	assert(post.values[TRANSLATE_VALUATOR_VSCROLL] == -3);
+
+	assert(!translate_axis(&d, 0, 1.0, 1, NAN, NAN, &post));
+}
+
+int
+main(int argc, char **argv)
+{
+	test_parse_button_map();
+	test_parse_output_area();
+	test_output_area_matrix();
+	test_motion_absolute_duplicates();
+	test_touch_duplicates();
+	test_axis_wheel_scaling();
+
+	return 0;
+}
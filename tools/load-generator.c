@@ -0,0 +1,519 @@
+/*
+ * Copyright © 2015 Red Hat, Inc.
+ *
+ * Permission to use, copy, modify, distribute, and sell this software
+ * and its documentation for any purpose is hereby granted without
+ * fee, provided that the above copyright notice appear in all copies
+ * and that both that copyright notice and this permission notice
+ * appear in supporting documentation, and that the name of Red Hat
+ * not be used in advertising or publicity pertaining to distribution
+ * of the software without specific, written prior permission.  Red
+ * Hat makes no representations about the suitability of this software
+ * for any purpose.  It is provided "as is" without express or implied
+ * warranty.
+ *
+ * THE AUTHORS DISCLAIM ALL WARRANTIES WITH REGARD TO THIS SOFTWARE,
+ * INCLUDING ALL IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS, IN
+ * NO EVENT SHALL THE AUTHORS BE LIABLE FOR ANY SPECIAL, INDIRECT OR
+ * CONSEQUENTIAL DAMAGES OR ANY DAMAGES WHATSOEVER RESULTING FROM LOSS
+ * OF USE, DATA OR PROFITS, WHETHER IN AN ACTION OF CONTRACT,
+ * NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF OR IN
+ * CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+ */
+
+/*
+   Creates a number of virtual devices through uinput and emits events on
+   them at a fixed rate, to put a running X server with the libinput
+   driver under the load of many active devices. It reports how many
+   events were written, how late the generator's own ticks ran and how
+   much CPU time it and, optionally, the server used.
+
+   The tick lateness is the generator's scheduling jitter, it does not
+   include any time spent in the kernel, libinput or the driver. For
+   the driver's latency, see the latency histogram in the statistics
+   file (tools/stats-reader).
+
+   Must be run as a user with write access to /dev/uinput.
+ */
+
+#ifdef HAVE_CONFIG_H
+#include "config.h"
+#endif
+
+#include <errno.h>
+#include <fcntl.h>
+#include <getopt.h>
+#include <signal.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+#include <sys/ioctl.h>
+#include <linux/input.h>
+#include <linux/uinput.h>
+
+#define MAX_DEVICES 256
+#define TOUCH_AXIS_MAX 4095
+
+enum device_type {
+	DEVICE_POINTER,
+	DEVICE_KEYBOARD,
+	DEVICE_TOUCH,
+	DEVICE_MIXED, /* round-robin of the above */
+};
+
+enum pattern {
+	PATTERN_STEADY,	/* one frame per device per tick */
+	PATTERN_BURST,	/* a tenth of a second's frames at once */
+};
+
+struct device {
+	int fd;
+	enum device_type type;
+	unsigned int frame;
+};
+
+struct options {
+	unsigned int ndevices;
+	unsigned int rate; /* frames per second per device */
+	unsigned int duration; /* seconds */
+	enum device_type type;
+	enum pattern pattern;
+	pid_t server_pid;
+};
+
+static volatile sig_atomic_t stop;
+
+static void
+sighandler(int sig)
+{
+	stop = 1;
+}
+
+static uint64_t
+now_us(void)
+{
+	struct timespec ts;
+
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return (uint64_t)ts.tv_sec * 1000000 + ts.tv_nsec / 1000;
+}
+
+static int
+emit(int fd, uint16_t type, uint16_t code, int32_t value)
+{
+	struct input_event ev;
+
+	memset(&ev, 0, sizeof(ev));
+	ev.type = type;
+	ev.code = code;
+	ev.value = value;
+
+	return write(fd, &ev, sizeof(ev)) == sizeof(ev) ? 0 : -1;
+}
+
+static int
+device_create(struct device *d, enum device_type type, unsigned int idx)
+{
+	struct uinput_user_dev udev;
+	int fd;
+	int i;
+
+	fd = open("/dev/uinput", O_WRONLY|O_NONBLOCK);
+	if (fd < 0)
+		return -errno;
+
+	memset(&udev, 0, sizeof(udev));
+	udev.id.bustype = BUS_VIRTUAL;
+	udev.id.vendor = 0x1;
+	udev.id.product = 0x1 + type;
+
+	switch (type) {
+	case DEVICE_POINTER:
+		snprintf(udev.name, sizeof(udev.name),
+			 "load generator pointer %u", idx);
+		ioctl(fd, UI_SET_EVBIT, EV_KEY);
+		ioctl(fd, UI_SET_KEYBIT, BTN_LEFT);
+		ioctl(fd, UI_SET_KEYBIT, BTN_RIGHT);
+		ioctl(fd, UI_SET_KEYBIT, BTN_MIDDLE);
+		ioctl(fd, UI_SET_EVBIT, EV_REL);
+		ioctl(fd, UI_SET_RELBIT, REL_X);
+		ioctl(fd, UI_SET_RELBIT, REL_Y);
+		ioctl(fd, UI_SET_RELBIT, REL_WHEEL);
+		break;
+	case DEVICE_KEYBOARD:
+		snprintf(udev.name, sizeof(udev.name),
+			 "load generator keyboard %u", idx);
+		ioctl(fd, UI_SET_EVBIT, EV_KEY);
+		for (i = KEY_F13; i <= KEY_F24; i++)
+			ioctl(fd, UI_SET_KEYBIT, i);
+		break;
+	case DEVICE_TOUCH:
+		snprintf(udev.name, sizeof(udev.name),
+			 "load generator touchscreen %u", idx);
+		ioctl(fd, UI_SET_EVBIT, EV_KEY);
+		ioctl(fd, UI_SET_KEYBIT, BTN_TOUCH);
+		ioctl(fd, UI_SET_EVBIT, EV_ABS);
+		ioctl(fd, UI_SET_ABSBIT, ABS_X);
+		ioctl(fd, UI_SET_ABSBIT, ABS_Y);
+		ioctl(fd, UI_SET_ABSBIT, ABS_MT_SLOT);
+		ioctl(fd, UI_SET_ABSBIT, ABS_MT_TRACKING_ID);
+		ioctl(fd, UI_SET_ABSBIT, ABS_MT_POSITION_X);
+		ioctl(fd, UI_SET_ABSBIT, ABS_MT_POSITION_Y);
+		ioctl(fd, UI_SET_PROPBIT, INPUT_PROP_DIRECT);
+		udev.absmax[ABS_X] = TOUCH_AXIS_MAX;
+		udev.absmax[ABS_Y] = TOUCH_AXIS_MAX;
+		udev.absmax[ABS_MT_SLOT] = 1;
+		udev.absmax[ABS_MT_TRACKING_ID] = 0xffff;
+		udev.absmax[ABS_MT_POSITION_X] = TOUCH_AXIS_MAX;
+		udev.absmax[ABS_MT_POSITION_Y] = TOUCH_AXIS_MAX;
+		break;
+	default:
+		close(fd);
+		return -EINVAL;
+	}
+
+	if (write(fd, &udev, sizeof(udev)) != sizeof(udev) ||
+	    ioctl(fd, UI_DEV_CREATE) < 0) {
+		int err = -errno;
+
+		close(fd);
+		return err;
+	}
+
+	d->fd = fd;
+	d->type = type;
+	d->frame = 0;
+
+	return 0;
+}
+
+static void
+device_destroy(struct device *d)
+{
+	ioctl(d->fd, UI_DEV_DESTROY);
+	close(d->fd);
+}
+
+/* Emit one frame of events. Returns the number of events written,
+   excluding the SYN_REPORT, or -1 on error */
+static int
+device_frame(struct device *d)
+{
+	unsigned int f = d->frame++;
+	int fd = d->fd;
+	int n = 0;
+
+	switch (d->type) {
+	case DEVICE_POINTER:
+		/* move in a square, click and scroll every now and then */
+		n += emit(fd, EV_REL, REL_X, (f / 64) % 2 ? -2 : 2) == 0;
+		n += emit(fd, EV_REL, REL_Y, (f / 32) % 2 ? -1 : 1) == 0;
+		if (f % 97 == 0)
+			n += emit(fd, EV_REL, REL_WHEEL, 1) == 0;
+		if (f % 200 == 0)
+			n += emit(fd, EV_KEY, BTN_LEFT, 1) == 0;
+		else if (f % 200 == 1)
+			n += emit(fd, EV_KEY, BTN_LEFT, 0) == 0;
+		break;
+	case DEVICE_KEYBOARD:
+		/* alternating press and release through keys that usually
+		   don't have any bindings */
+		n += emit(fd, EV_KEY, KEY_F13 + (f / 2) % 12, f % 2 == 0) == 0;
+		break;
+	case DEVICE_TOUCH: {
+		/* a touch that moves for 100 frames then lifts */
+		unsigned int t = f % 101;
+		int pos = 100 + t * 30;
+
+		if (t == 100) {
+			n += emit(fd, EV_ABS, ABS_MT_TRACKING_ID, -1) == 0;
+			n += emit(fd, EV_KEY, BTN_TOUCH, 0) == 0;
+			break;
+		}
+		if (t == 0) {
+			n += emit(fd, EV_ABS, ABS_MT_SLOT, 0) == 0;
+			n += emit(fd, EV_ABS, ABS_MT_TRACKING_ID, f / 101) == 0;
+			n += emit(fd, EV_KEY, BTN_TOUCH, 1) == 0;
+		}
+		n += emit(fd, EV_ABS, ABS_MT_POSITION_X, pos) == 0;
+		n += emit(fd, EV_ABS, ABS_MT_POSITION_Y, pos) == 0;
+		n += emit(fd, EV_ABS, ABS_X, pos) == 0;
+		n += emit(fd, EV_ABS, ABS_Y, pos) == 0;
+		break;
+	}
+	default:
+		break;
+	}
+
+	if (emit(fd, EV_SYN, SYN_REPORT, 0) < 0)
+		return -1;
+
+	return n;
+}
+
+/* Returns user+system time of the process in µs, or 0 on error */
+static uint64_t
+cpu_time_us(pid_t pid)
+{
+	char path[64];
+	FILE *f;
+	unsigned long utime, stime;
+	int rc;
+	long hz = sysconf(_SC_CLK_TCK);
+
+	snprintf(path, sizeof(path), "/proc/%d/stat", pid ? pid : getpid());
+	f = fopen(path, "r");
+	if (!f)
+		return 0;
+
+	/* comm may contain spaces, skip to after the closing paren */
+	rc = fscanf(f, "%*d (%*[^)]) %*c %*d %*d %*d %*d %*d %*u %*u %*u %*u %*u %lu %lu",
+		    &utime, &stime);
+	fclose(f);
+
+	if (rc != 2 || hz <= 0)
+		return 0;
+
+	return (uint64_t)(utime + stime) * 1000000 / hz;
+}
+
+static int
+compare_u32(const void *a, const void *b)
+{
+	uint32_t x = *(const uint32_t*)a,
+		 y = *(const uint32_t*)b;
+
+	return x < y ? -1 : x > y;
+}
+
+static void
+usage(const char *name)
+{
+	printf("Usage: %s [options]\n"
+	       "\n"
+	       "--devices=N ........ number of virtual devices (default 1, max %d)\n"
+	       "--rate=HZ .......... frames per second per device (default 125)\n"
+	       "--duration=S ....... run time in seconds (default 10)\n"
+	       "--type=TYPE ........ pointer, keyboard, touch or mixed (default mixed)\n"
+	       "--pattern=PATTERN .. steady or burst (default steady)\n"
+	       "--server-pid=PID ... also report the CPU time used by this process\n",
+	       name, MAX_DEVICES);
+}
+
+static int
+parse_options(int argc, char **argv, struct options *options)
+{
+	enum {
+		OPT_DEVICES,
+		OPT_RATE,
+		OPT_DURATION,
+		OPT_TYPE,
+		OPT_PATTERN,
+		OPT_SERVER_PID,
+		OPT_HELP,
+	};
+	static const struct option opts[] = {
+		{ "devices", required_argument, 0, OPT_DEVICES },
+		{ "rate", required_argument, 0, OPT_RATE },
+		{ "duration", required_argument, 0, OPT_DURATION },
+		{ "type", required_argument, 0, OPT_TYPE },
+		{ "pattern", required_argument, 0, OPT_PATTERN },
+		{ "server-pid", required_argument, 0, OPT_SERVER_PID },
+		{ "help", no_argument, 0, OPT_HELP },
+		{ 0, 0, 0, 0 },
+	};
+	int c;
+
+	options->ndevices = 1;
+	options->rate = 125;
+	options->duration = 10;
+	options->type = DEVICE_MIXED;
+	options->pattern = PATTERN_STEADY;
+	options->server_pid = 0;
+
+	while ((c = getopt_long(argc, argv, "h", opts, NULL)) != -1) {
+		switch (c) {
+		case OPT_DEVICES:
+			options->ndevices = atoi(optarg);
+			break;
+		case OPT_RATE:
+			options->rate = atoi(optarg);
+			break;
+		case OPT_DURATION:
+			options->duration = atoi(optarg);
+			break;
+		case OPT_TYPE:
+			if (strcmp(optarg, "pointer") == 0)
+				options->type = DEVICE_POINTER;
+			else if (strcmp(optarg, "keyboard") == 0)
+				options->type = DEVICE_KEYBOARD;
+			else if (strcmp(optarg, "touch") == 0)
+				options->type = DEVICE_TOUCH;
+			else if (strcmp(optarg, "mixed") == 0)
+				options->type = DEVICE_MIXED;
+			else
+				return -1;
+			break;
+		case OPT_PATTERN:
+			if (strcmp(optarg, "steady") == 0)
+				options->pattern = PATTERN_STEADY;
+			else if (strcmp(optarg, "burst") == 0)
+				options->pattern = PATTERN_BURST;
+			else
+				return -1;
+			break;
+		case OPT_SERVER_PID:
+			options->server_pid = atoi(optarg);
+			break;
+		case 'h':
+		case OPT_HELP:
+		default:
+			return -1;
+		}
+	}
+
+	if (optind < argc ||
+	    options->ndevices == 0 || options->ndevices > MAX_DEVICES ||
+	    options->rate == 0 || options->rate > 10000 ||
+	    options->duration == 0)
+		return -1;
+
+	return 0;
+}
+
+int
+main(int argc, char **argv)
+{
+	struct options options;
+	struct device devices[MAX_DEVICES];
+	unsigned int ndevices = 0;
+	unsigned int frames_per_tick, tick_us;
+	uint32_t *jitter = NULL;
+	size_t nticks = 0, max_ticks;
+	uint64_t start, next, end, elapsed;
+	uint64_t nevents = 0, nframes = 0, nerrors = 0;
+	uint64_t cpu_self, cpu_server = 0;
+	unsigned int i;
+	int rc = 1;
+
+	if (parse_options(argc, argv, &options) != 0) {
+		usage(argv[0]);
+		return 1;
+	}
+
+	signal(SIGINT, sighandler);
+	signal(SIGTERM, sighandler);
+
+	for (i = 0; i < options.ndevices; i++) {
+		enum device_type type = options.type;
+		int err;
+
+		if (type == DEVICE_MIXED)
+			type = i % DEVICE_MIXED;
+
+		err = device_create(&devices[i], type, i);
+		if (err < 0) {
+			fprintf(stderr, "Failed to create device %u: %s\n",
+				i, strerror(-err));
+			goto out;
+		}
+		ndevices++;
+	}
+
+	/* give the server time to pick up the new devices */
+	sleep(2);
+
+	if (options.pattern == PATTERN_BURST) {
+		tick_us = 100000;
+		frames_per_tick = (options.rate + 9) / 10;
+	} else {
+		tick_us = 1000000 / options.rate;
+		frames_per_tick = 1;
+	}
+
+	max_ticks = (uint64_t)options.duration * 1000000 / tick_us + 1;
+	jitter = calloc(max_ticks, sizeof(*jitter));
+	if (!jitter)
+		goto out;
+
+	printf("%u devices, %u frames/s each, %s, %us\n",
+	       ndevices, options.rate,
+	       options.pattern == PATTERN_BURST ? "burst" : "steady",
+	       options.duration);
+
+	cpu_self = cpu_time_us(0);
+	if (options.server_pid)
+		cpu_server = cpu_time_us(options.server_pid);
+
+	start = now_us();
+	end = start + (uint64_t)options.duration * 1000000;
+	next = start;
+
+	while (!stop && next < end && nticks < max_ticks) {
+		struct timespec ts;
+		uint64_t now;
+		unsigned int f;
+
+		ts.tv_sec = next / 1000000;
+		ts.tv_nsec = (next % 1000000) * 1000;
+		while (clock_nanosleep(CLOCK_MONOTONIC, TIMER_ABSTIME,
+				       &ts, NULL) == EINTR && !stop)
+			;
+
+		now = now_us();
+		jitter[nticks++] = now > next ? now - next : 0;
+
+		for (f = 0; f < frames_per_tick; f++) {
+			for (i = 0; i < ndevices; i++) {
+				int n = device_frame(&devices[i]);
+
+				if (n < 0) {
+					nerrors++;
+				} else {
+					nevents += n;
+					nframes++;
+				}
+			}
+		}
+
+		next += tick_us;
+		/* don't try to catch up if we fell far behind, just
+		   report it */
+		if (now > next + tick_us * 10)
+			next = now;
+	}
+
+	elapsed = now_us() - start;
+	cpu_self = cpu_time_us(0) - cpu_self;
+	if (options.server_pid)
+		cpu_server = cpu_time_us(options.server_pid) - cpu_server;
+
+	qsort(jitter, nticks, sizeof(*jitter), compare_u32);
+
+	printf("elapsed:          %.2fs\n", elapsed / 1e6);
+	printf("frames written:   %llu (%.0f/s)\n",
+	       (unsigned long long)nframes, nframes * 1e6 / elapsed);
+	printf("events written:   %llu (%.0f/s)\n",
+	       (unsigned long long)nevents, nevents * 1e6 / elapsed);
+	printf("write errors:     %llu\n", (unsigned long long)nerrors);
+	if (nticks > 0)
+		printf("generator jitter: p50 %uus p90 %uus p99 %uus max %uus\n",
+		       jitter[nticks * 50 / 100],
+		       jitter[nticks * 90 / 100],
+		       jitter[nticks * 99 / 100],
+		       jitter[nticks - 1]);
+	printf("generator cpu:    %.1f%%\n", cpu_self * 100.0 / elapsed);
+	if (options.server_pid)
+		printf("server cpu:       %.1f%%\n", cpu_server * 100.0 / elapsed);
+
+	rc = 0;
+out:
+	free(jitter);
+	for (i = 0; i < ndevices; i++)
+		device_destroy(&devices[i]);
+
+	return rc;
+}
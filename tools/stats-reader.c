@@ -0,0 +1,193 @@
+/*
+ * Copyright © 2015 Red Hat, Inc.
+ *
+ * Permission to use, copy, modify, distribute, and sell this software
+ * and its documentation for any purpose is hereby granted without
+ * fee, provided that the above copyright notice appear in all copies
+ * and that both that copyright notice and this permission notice
+ * appear in supporting documentation, and that the name of Red Hat
+ * not be used in advertising or publicity pertaining to distribution
+ * of the software without specific, written prior permission.  Red
+ * Hat makes no representations about the suitability of this software
+ * for any purpose.  It is provided "as is" without express or implied
+ * warranty.
+ *
+ * THE AUTHORS DISCLAIM ALL WARRANTIES WITH REGARD TO THIS SOFTWARE,
+ * INCLUDING ALL IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS, IN
+ * NO EVENT SHALL THE AUTHORS BE LIABLE FOR ANY SPECIAL, INDIRECT OR
+ * CONSEQUENTIAL DAMAGES OR ANY DAMAGES WHATSOEVER RESULTING FROM LOSS
+ * OF USE, DATA OR PROFITS, WHETHER IN AN ACTION OF CONTRACT,
+ * NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF OR IN
+ * CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+ */
+
+/*
+   Prints the statistics file written by the driver if the
+   StatisticsDirectory option is set, once or at an interval. See
+   src/stats-export.h for the layout.
+ */
+
+#ifdef HAVE_CONFIG_H
+#include "config.h"
+#endif
+
+#include <errno.h>
+#include <fcntl.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+
+#include "stats-export.h"
+
+#define READ_RETRIES 100
+
+static const char *event_names[STATS_EXPORT_EVENT_TYPES] = {
+	"motion", "abs", "button", "key", "axis", "touch", "other",
+};
+
+/* Copy size bytes protected by seq into dest. Returns 0 on success or
+   -1 if the driver kept writing */
+static int
+read_consistent(const uint32_t *seq, const void *src, void *dest, size_t size)
+{
+	int i;
+
+	for (i = 0; i < READ_RETRIES; i++) {
+		uint32_t start;
+
+		if (!stats_export_read_begin(seq, &start))
+			continue;
+
+		memcpy(dest, src, size);
+
+		if (stats_export_read_end(seq, start))
+			return 0;
+	}
+
+	return -1;
+}
+
+static void
+print_histogram(const char *name, const uint64_t *buckets, size_t n)
+{
+	size_t i;
+
+	printf("  %s:", name);
+	for (i = 0; i < n; i++)
+		printf(" %llu", (unsigned long long)buckets[i]);
+	printf("\n");
+}
+
+static int
+print_stats(const char *map, size_t size)
+{
+	const struct stats_export_header *h = (const struct stats_export_header*)map;
+	struct stats_export_header header;
+	uint32_t i;
+
+	if (size < sizeof(header) ||
+	    __atomic_load_n(&h->magic, __ATOMIC_ACQUIRE) != STATS_EXPORT_MAGIC) {
+		fprintf(stderr, "Not a statistics file\n");
+		return -1;
+	}
+
+	if (h->version != STATS_EXPORT_VERSION ||
+	    h->header_size < sizeof(header) ||
+	    h->device_size < sizeof(struct stats_export_device) ||
+	    h->header_size + (size_t)h->max_devices * h->device_size > size) {
+		fprintf(stderr, "Unsupported statistics file version %u\n",
+			h->version);
+		return -1;
+	}
+
+	if (read_consistent(&h->seq, h, &header, sizeof(header)) < 0) {
+		fprintf(stderr, "Failed to read a consistent header\n");
+		return -1;
+	}
+
+	printf("wakeups %llu eagain %llu log suppressed %llu\n",
+	       (unsigned long long)header.wakeups,
+	       (unsigned long long)header.eagain,
+	       (unsigned long long)header.log_suppressed);
+	print_histogram("events per wakeup", header.drain,
+			STATS_EXPORT_DRAIN_BUCKETS);
+
+	for (i = 0; i < header.max_devices; i++) {
+		const struct stats_export_device *d;
+		struct stats_export_device dev;
+		int t;
+
+		d = (const struct stats_export_device*)(map + header.header_size +
+							 (size_t)i * header.device_size);
+		if (read_consistent(&d->seq, d, &dev, sizeof(dev)) < 0 ||
+		    dev.id == -1)
+			continue;
+
+		dev.name[sizeof(dev.name) - 1] = '\0';
+		printf("device %d \"%s\"\n", dev.id, dev.name);
+		printf("  events:");
+		for (t = 0; t < STATS_EXPORT_EVENT_TYPES; t++)
+			printf(" %s %llu", event_names[t],
+			       (unsigned long long)dev.events[t]);
+		printf("\n");
+		printf("  dropped: duplicate %llu throttled %llu\n",
+		       (unsigned long long)dev.suppressed_motion,
+		       (unsigned long long)dev.throttled_motion);
+		printf("  config applied: %llu\n",
+		       (unsigned long long)dev.config_applied);
+		print_histogram("latency (ms, log2 buckets)", dev.latency,
+				STATS_EXPORT_LATENCY_BUCKETS);
+	}
+
+	return 0;
+}
+
+int
+main(int argc, char **argv)
+{
+	struct stat st;
+	const char *path;
+	char *map;
+	int interval = 0;
+	int fd;
+	int rc;
+
+	if (argc < 2 || argc > 3) {
+		fprintf(stderr, "Usage: %s <statistics file> [interval in ms]\n",
+			argv[0]);
+		return 1;
+	}
+
+	path = argv[1];
+	if (argc == 3)
+		interval = atoi(argv[2]);
+
+	fd = open(path, O_RDONLY|O_CLOEXEC);
+	if (fd < 0 || fstat(fd, &st) < 0) {
+		fprintf(stderr, "Failed to open %s: %s\n", path, strerror(errno));
+		return 1;
+	}
+
+	map = mmap(NULL, st.st_size, PROT_READ, MAP_SHARED, fd, 0);
+	close(fd);
+	if (map == MAP_FAILED) {
+		fprintf(stderr, "Failed to map %s: %s\n", path, strerror(errno));
+		return 1;
+	}
+
+	do {
+		rc = print_stats(map, st.st_size);
+		if (rc < 0 || interval <= 0)
+			break;
+		printf("\n");
+		fflush(stdout);
+		usleep(interval * 1000);
+	} while (1);
+
+	munmap(map, st.st_size);
+
+	return rc < 0 ? 1 : 0;
+}